@@ -1,19 +1,35 @@
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <random>
 #include <regex>
+#include <thread>
 
+#include "boost/json.hpp"
 #include "boost/program_options.hpp"
 
+#include "cista/mmap.h"
+
+#include "utl/helpers/algorithm.h"
 #include "utl/parallel_for.h"
 #include "utl/progress_tracker.h"
+#include "utl/to_vec.h"
 
+#include "nigiri/compressed_bitfields.h"
 #include "nigiri/logging.h"
+#include "nigiri/mapped_timetable.h"
 #include "nigiri/qa/qa.h"
 #include "nigiri/query_generator/generator.h"
 #include "nigiri/routing/raptor/raptor.h"
 #include "nigiri/routing/raptor_search.h"
 #include "nigiri/routing/search.h"
+#include "nigiri/rt/create_rt_timetable.h"
+#include "nigiri/rt/gtfsrt_update.h"
+#include "nigiri/rt/rt_timetable.h"
 #include "nigiri/timetable.h"
 #include "nigiri/types.h"
 
@@ -21,6 +37,13 @@
 #include <sys/resource.h>
 #endif
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 using namespace nigiri;
 using namespace nigiri::routing;
 
@@ -72,6 +95,59 @@ std::optional<geo::latlng> parse_coord(std::string const& str) {
   return latlng{std::stod(tokens[0]), std::stod(tokens[1])};
 }
 
+#ifdef __linux__
+struct perf_counter {
+  perf_counter(std::uint32_t const type, std::uint64_t const config) {
+    auto attr = perf_event_attr{};
+    attr.type = type;
+    attr.size = sizeof(perf_event_attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0 /* this thread */,
+                -1 /* any cpu */, -1 /* no group */, 0UL));
+    if (fd_ != -1) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  perf_counter(perf_counter const&) = delete;
+  perf_counter& operator=(perf_counter const&) = delete;
+
+  ~perf_counter() {
+    if (fd_ != -1) {
+      close(fd_);
+    }
+  }
+
+  std::optional<std::uint64_t> read() const {
+    auto value = std::uint64_t{0U};
+    if (fd_ == -1 || ::read(fd_, &value, sizeof(value)) != sizeof(value)) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  int fd_{-1};
+};
+
+struct perf_counters {
+  perf_counter cycles_{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+  perf_counter llc_misses_{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+};
+#else
+struct perf_counter {
+  std::optional<std::uint64_t> read() const { return std::nullopt; }
+};
+
+struct perf_counters {
+  perf_counter cycles_, llc_misses_;
+};
+#endif
+
 struct benchmark_result {
   friend std::ostream& operator<<(std::ostream& out,
                                   benchmark_result const& br) {
@@ -96,7 +172,9 @@ struct benchmark_result {
   std::uint64_t q_idx_;
   routing_result routing_result_;
   pareto_set<journey> journeys_;
-  std::chrono::milliseconds total_time_;
+  std::chrono::microseconds total_time_;
+  std::optional<std::uint64_t> cycles_;
+  std::optional<std::uint64_t> llc_misses_;
 };
 
 void generate_queries(
@@ -137,7 +215,8 @@ nigiri::pareto_set<nigiri::routing::journey> raptor_search(
 void process_queries(
     std::vector<nigiri::query_generation::start_dest_query> const& queries,
     std::vector<benchmark_result>& results,
-    nigiri::timetable const& tt) {
+    nigiri::timetable const& tt,
+    bool const collect_perf_counters) {
   results.reserve(queries.size());
   std::mutex mutex;
   {
@@ -149,20 +228,44 @@ void process_queries(
     struct query_state {
       search_state ss_;
       raptor_state rs_;
+      std::unique_ptr<perf_counters> perf_;
     };
     utl::parallel_for_run_threadlocal<query_state>(
         queries.size(), [&](auto& query_state, auto const q_idx) {
           try {
+            if (collect_perf_counters && query_state.perf_ == nullptr) {
+              query_state.perf_ = std::make_unique<perf_counters>();
+            }
+            auto const read_counter = [&](auto const member) {
+              return query_state.perf_ == nullptr
+                         ? std::nullopt
+                         : ((*query_state.perf_).*member).read();
+            };
+            auto const diff = [](std::optional<std::uint64_t> const a,
+                                 std::optional<std::uint64_t> const b) {
+              return a.has_value() && b.has_value()
+                         ? std::optional{*b - *a}
+                         : std::nullopt;
+            };
+
+            auto const cycles_start = read_counter(&perf_counters::cycles_);
+            auto const llc_misses_start =
+                read_counter(&perf_counters::llc_misses_);
             auto const total_time_start = std::chrono::steady_clock::now();
             auto const result = routing::raptor_search(
                 tt, nullptr, query_state.ss_, query_state.rs_,
                 queries[q_idx].q_, direction::kForward);
             auto const total_time_stop = std::chrono::steady_clock::now();
+            auto const cycles =
+                diff(cycles_start, read_counter(&perf_counters::cycles_));
+            auto const llc_misses = diff(
+                llc_misses_start, read_counter(&perf_counters::llc_misses_));
             auto const guard = std::lock_guard{mutex};
             results.emplace_back(benchmark_result{
                 q_idx, result, *result.journeys_,
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                    total_time_stop - total_time_start)});
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    total_time_stop - total_time_start),
+                cycles, llc_misses});
             progress_tracker->increment();
           } catch (std::exception const& e) {
             std::cout << e.what();
@@ -303,6 +406,340 @@ void print_results(
   print_result(results, "#journeys");
 }
 
+std::map<std::string, std::vector<std::uint64_t>> collect_metrics(
+    std::vector<benchmark_result> const& results) {
+  auto metrics = std::map<std::string, std::vector<std::uint64_t>>{};
+  auto const add = [&](std::string const& name, std::uint64_t const value) {
+    metrics[name].emplace_back(value);
+  };
+  for (auto const& r : results) {
+    auto const& s = r.routing_result_.search_stats_;
+    add("total_time_us", static_cast<std::uint64_t>(r.total_time_.count()));
+    add("lb_time_ms", s.lb_time_);
+    add("start_label_time_us",
+        static_cast<std::uint64_t>(s.start_label_time_.count()));
+    add("algo_time_us", static_cast<std::uint64_t>(s.algo_time_.count()));
+    add("reconstruct_time_us",
+        static_cast<std::uint64_t>(s.reconstruct_time_.count()));
+    add("interval_extensions", s.interval_extensions_);
+    add("n_journeys", r.journeys_.size());
+    for (auto const& [name, value] : r.routing_result_.algo_stats_) {
+      add("raptor." + name, value);
+    }
+    if (r.cycles_.has_value()) {
+      add("perf.cycles", *r.cycles_);
+    }
+    if (r.llc_misses_.has_value()) {
+      add("perf.llc_misses", *r.llc_misses_);
+    }
+  }
+  for (auto& [_, values] : metrics) {
+    utl::sort(values);
+  }
+  return metrics;
+}
+
+boost::json::object to_json(std::vector<std::uint64_t> const& sorted) {
+  auto sum = 0.0;
+  for (auto const v : sorted) {
+    sum += static_cast<double>(v);
+  }
+
+  // Histogram with power of two buckets: [upper_bound, count] pairs.
+  auto histogram = boost::json::array{};
+  auto upper_bound = std::uint64_t{1U};
+  auto it = begin(sorted);
+  while (it != end(sorted)) {
+    auto const next = std::lower_bound(it, end(sorted), upper_bound);
+    if (next != it) {
+      histogram.emplace_back(
+          boost::json::array{upper_bound, std::distance(it, next)});
+    }
+    it = next;
+    upper_bound *= 2U;
+  }
+
+  auto o = boost::json::object{};
+  o["n"] = sorted.size();
+  o["mean"] = sum / static_cast<double>(sorted.size());
+  o["p50"] = quantile(sorted, 0.5);
+  o["p90"] = quantile(sorted, 0.9);
+  o["p99"] = quantile(sorted, 0.99);
+  o["p99.9"] = quantile(sorted, 0.999);
+  o["max"] = sorted.back();
+  o["histogram"] = std::move(histogram);
+  return o;
+}
+
+boost::json::object make_report(std::vector<benchmark_result> const& results) {
+  auto metrics = boost::json::object{};
+  for (auto const& [name, values] : collect_metrics(results)) {
+    metrics.emplace(name, to_json(values));
+  }
+  auto report = boost::json::object{};
+  report["version"] = 1;
+  report["n_queries"] = results.size();
+  report["metrics"] = std::move(metrics);
+  return report;
+}
+
+void print_percentiles(std::vector<benchmark_result> const& results) {
+  std::cout << "\n--- percentiles ---\n"
+            << std::setw(44) << std::left << "metric" << std::right
+            << std::setw(12) << "p50" << std::setw(12) << "p90"
+            << std::setw(12) << "p99" << std::setw(12) << "p99.9"
+            << std::setw(12) << "max" << "\n";
+  for (auto const& [name, v] : collect_metrics(results)) {
+    std::cout << std::setw(44) << std::left << name << std::right
+              << std::setw(12) << quantile(v, 0.5) << std::setw(12)
+              << quantile(v, 0.9) << std::setw(12) << quantile(v, 0.99)
+              << std::setw(12) << quantile(v, 0.999) << std::setw(12)
+              << v.back() << "\n";
+  }
+}
+
+boost::json::object read_report(std::filesystem::path const& path) {
+  auto in = std::ifstream{path};
+  auto const content = std::string{std::istreambuf_iterator<char>{in},
+                                   std::istreambuf_iterator<char>{}};
+  return boost::json::parse(content).as_object();
+}
+
+// Returns the number of regressions: metric percentiles that got worse by more
+// than the given threshold (in percent). Only timing and perf counter metrics
+// are compared, counters (routes visited, etc.) are just informative.
+unsigned compare_reports(boost::json::object const& baseline,
+                         boost::json::object const& current,
+                         double const threshold_percent) {
+  auto const is_compared = [](std::string_view name) {
+    return name.ends_with("_us") || name.ends_with("_ms") ||
+           name.starts_with("perf.");
+  };
+
+  auto n_regressions = 0U;
+  auto const& base_metrics = baseline.at("metrics").as_object();
+  auto const& curr_metrics = current.at("metrics").as_object();
+  std::cout << std::setw(32) << std::left << "metric" << std::setw(8)
+            << "pctl" << std::right << std::setw(14) << "baseline"
+            << std::setw(14) << "current" << std::setw(10) << "change"
+            << "\n";
+  for (auto const& [name, base] : base_metrics) {
+    if (!is_compared(name) || !curr_metrics.contains(name)) {
+      continue;
+    }
+    auto const& curr = curr_metrics.at(name).as_object();
+    for (auto const* pctl : {"p50", "p90", "p99", "p99.9"}) {
+      auto const b = base.as_object().at(pctl).to_number<double>();
+      auto const c = curr.at(pctl).to_number<double>();
+      auto const change = b == 0.0 ? 0.0 : (c - b) / b * 100.0;
+      auto const regression = change > threshold_percent;
+      n_regressions += regression ? 1U : 0U;
+      std::cout << std::setw(32) << std::left << std::string_view{name}
+                << std::setw(8) << pctl << std::right << std::setw(14) << b
+                << std::setw(14) << c << std::setw(9) << std::fixed
+                << std::setprecision(1) << change << "%"
+                << (regression ? "  REGRESSION" : "") << "\n";
+    }
+  }
+  return n_regressions;
+}
+
+struct load_settings {
+  std::vector<double> rates_;
+  std::filesystem::path arrival_trace_;
+  double rt_share_{0.0};
+  std::vector<std::filesystem::path> rt_updates_;
+  std::chrono::milliseconds rt_update_interval_{10'000};
+  unsigned n_threads_{std::thread::hardware_concurrency()};
+  std::int64_t seed_{-1};
+};
+
+struct load_result {
+  std::chrono::microseconds queueing_time_;
+  std::chrono::microseconds service_time_;
+  bool rt_;
+};
+
+// Arrival offsets relative to the start of the load test.
+std::vector<std::chrono::microseconds> get_arrivals(load_settings const& ls,
+                                                    double const rate,
+                                                    std::size_t const n) {
+  auto arrivals = std::vector<std::chrono::microseconds>{};
+  arrivals.reserve(n);
+  if (!ls.arrival_trace_.empty()) {
+    // One timestamp (milliseconds) per line, sorted and replayed relative to
+    // the earliest one (unsorted traces would yield negative offsets).
+    auto in = std::ifstream{ls.arrival_trace_};
+    auto timestamps = std::vector<std::int64_t>{};
+    auto ts = std::int64_t{};
+    while (timestamps.size() != n && (in >> ts)) {
+      timestamps.emplace_back(ts);
+    }
+    std::sort(begin(timestamps), end(timestamps));
+    for (auto const x : timestamps) {
+      arrivals.emplace_back(std::chrono::milliseconds{x - timestamps.front()});
+    }
+  } else {
+    // Poisson process: exponentially distributed inter-arrival times.
+    auto rng = ls.seed_ > -1 ? std::mt19937_64{static_cast<std::uint64_t>(
+                                   ls.seed_)}
+                             : std::mt19937_64{std::random_device{}()};
+    auto dist = std::exponential_distribution<double>{rate};
+    auto t = 0.0;
+    for (auto i = 0U; i != n; ++i) {
+      arrivals.emplace_back(static_cast<std::int64_t>(t * 1'000'000.0));
+      t += dist(rng);
+    }
+  }
+  return arrivals;
+}
+
+void print_load_result(double const rate,
+                       std::chrono::microseconds const duration,
+                       std::vector<load_result> const& results) {
+  if (results.empty()) {
+    std::cout << "\n--- load: target=" << rate << " q/s, no queries ---\n";
+    return;
+  }
+
+  auto const percentiles = [&](auto&& get) {
+    auto v = utl::to_vec(results, [&](load_result const& r) {
+      return static_cast<std::uint64_t>(get(r).count());
+    });
+    utl::sort(v);
+    return std::array{quantile(v, 0.5), quantile(v, 0.9), quantile(v, 0.99),
+                      quantile(v, 0.999)};
+  };
+
+  auto const achieved = static_cast<double>(results.size()) /
+                        std::chrono::duration<double>{duration}.count();
+  std::cout << "\n--- load: target=" << rate << " q/s, achieved=" << achieved
+            << " q/s, n=" << results.size() << ", rt="
+            << utl::count_if(results, [](auto&& r) { return r.rt_; })
+            << " ---\n"
+            << std::setw(12) << std::left << "[us]" << std::right
+            << std::setw(12) << "p50" << std::setw(12) << "p90"
+            << std::setw(12) << "p99" << std::setw(12) << "p99.9" << "\n";
+  auto const print_row = [](char const* name, auto const& p) {
+    std::cout << std::setw(12) << std::left << name << std::right;
+    for (auto const x : p) {
+      std::cout << std::setw(12) << x;
+    }
+    std::cout << "\n";
+  };
+  print_row("queueing",
+            percentiles([](load_result const& r) { return r.queueing_time_; }));
+  print_row("service",
+            percentiles([](load_result const& r) { return r.service_time_; }));
+  print_row("latency", percentiles([](load_result const& r) {
+              return r.queueing_time_ + r.service_time_;
+            }));
+}
+
+// Open-loop load test: queries arrive according to a Poisson process (or a
+// recorded trace) independent of the system's response times. Workers pick up
+// queries in arrival order. Queueing delay (arrival -> start) and service time
+// (start -> end) are reported separately. GTFS-RT updates can be applied
+// concurrently: each update is applied to a copy of the current RT timetable
+// which then replaces it for subsequent queries.
+void run_load_test(
+    std::vector<nigiri::query_generation::start_dest_query> const& queries,
+    nigiri::timetable const& tt,
+    load_settings const& ls) {
+  auto rtt_mutex = std::mutex{};
+  auto rtt = std::shared_ptr<rt_timetable>{};
+  auto const has_rt = ls.rt_share_ > 0.0 || !ls.rt_updates_.empty();
+  if (has_rt) {
+    auto const today = std::chrono::time_point_cast<date::days>(
+        std::chrono::system_clock::now());
+    rtt = std::make_shared<rt_timetable>(rt::create_rt_timetable(
+        tt, tt.internal_interval_days().contains(today)
+                ? today
+                : tt.internal_interval_days().from_));
+  }
+  auto const get_rtt = [&]() {
+    auto const lock = std::scoped_lock{rtt_mutex};
+    return rtt;
+  };
+
+  auto const rates = ls.arrival_trace_.empty() ? ls.rates_
+                                               : std::vector<double>{0.0};
+  for (auto const rate : rates) {
+    auto const arrivals = get_arrivals(ls, rate, queries.size());
+
+    auto stop_updates = std::atomic_bool{false};
+    auto n_updates = 0U;
+    auto updater = std::thread{[&]() {
+      for (auto i = 0U; !ls.rt_updates_.empty() && !stop_updates; ++i) {
+        auto const& path = ls.rt_updates_[i % ls.rt_updates_.size()];
+        try {
+          auto const file =
+              cista::mmap{path.generic_string().c_str(),
+                          cista::mmap::protection::READ};
+          auto next = std::make_shared<rt_timetable>(*get_rtt());
+          rt::gtfsrt_update_buf(tt, *next, source_idx_t{0U}, "", file.view());
+          {
+            auto const lock = std::scoped_lock{rtt_mutex};
+            rtt = std::move(next);
+          }
+          ++n_updates;
+        } catch (std::exception const& e) {
+          std::cout << "RT update " << path << " failed: " << e.what() << "\n";
+        }
+        auto const until =
+            std::chrono::steady_clock::now() + ls.rt_update_interval_;
+        while (!stop_updates && std::chrono::steady_clock::now() < until) {
+          std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+      }
+    }};
+
+    auto results = std::vector<load_result>(arrivals.size());
+    auto next = std::atomic_size_t{0U};
+    auto const start = std::chrono::steady_clock::now();
+    auto workers = std::vector<std::thread>{};
+    for (auto t = 0U; t != std::max(ls.n_threads_, 1U); ++t) {
+      workers.emplace_back([&, t]() {
+        auto ss = search_state{};
+        auto rs = raptor_state{};
+        auto rng = std::mt19937{t};
+        auto rt_dist = std::bernoulli_distribution{ls.rt_share_};
+        for (auto i = next++; i < arrivals.size(); i = next++) {
+          std::this_thread::sleep_until(start + arrivals[i]);
+          auto const use_rt = has_rt && rt_dist(rng);
+          auto const q_rtt = use_rt ? get_rtt() : nullptr;
+          auto const service_start = std::chrono::steady_clock::now();
+          try {
+            routing::raptor_search(tt, q_rtt.get(), ss, rs, queries[i].q_,
+                                   direction::kForward);
+          } catch (std::exception const& e) {
+            nigiri::log(log_lvl::error, "benchmark.load",
+                        "query {} failed: {}", i, e.what());
+          }
+          auto const service_end = std::chrono::steady_clock::now();
+          results[i] = {std::chrono::duration_cast<std::chrono::microseconds>(
+                            service_start - (start + arrivals[i])),
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            service_end - service_start),
+                        use_rt};
+        }
+      });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+    auto const duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    stop_updates = true;
+    updater.join();
+
+    print_load_result(rate, duration, results);
+    if (n_updates != 0U) {
+      std::cout << "RT updates applied concurrently: " << n_updates << "\n";
+    }
+  }
+}
+
 void print_memory_usage() {
 #ifndef _WIN32
   auto r = rusage{};
@@ -312,6 +749,65 @@ void print_memory_usage() {
 #endif
 }
 
+void run_bitfield_benchmark(timetable const& tt, std::int64_t const seed) {
+  auto const raw_bytes = tt.bitfields_.size() * sizeof(bitfield);
+  auto const compress_start = std::chrono::steady_clock::now();
+  auto const compressed = compress(tt.bitfields_);
+  auto const compress_time =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - compress_start);
+
+  std::cout << "\n--- bitfields ---\n"
+            << "bitfields: " << tt.bitfields_.size()
+            << ", distinct 64 day blocks: " << compressed.dict_.size()
+            << "\nraw: " << raw_bytes / 1024.0 << " KiB"
+            << "\ncompressed: " << compressed.size_bytes() / 1024.0 << " KiB ("
+            << 100.0 * static_cast<double>(compressed.size_bytes()) /
+                   static_cast<double>(raw_bytes)
+            << "%)\ncompression time: " << compress_time.count() << "ms\n";
+
+  if (tt.transport_traffic_days_.empty()) {
+    return;
+  }
+
+  // Random (transport, day) lookups as done by the routing.
+  constexpr auto const kLookups = 50'000'000U;
+  auto rng = std::mt19937{seed > -1 ? static_cast<std::uint32_t>(seed)
+                                    : std::random_device{}()};
+  auto transport_dist = std::uniform_int_distribution<std::uint32_t>{
+      0U, static_cast<std::uint32_t>(tt.transport_traffic_days_.size() - 1U)};
+  auto day_dist = std::uniform_int_distribution<std::uint32_t>{
+      0U, static_cast<std::uint32_t>(tt.internal_interval_days().size() /
+                                     date::days{1})};
+  auto lookups = std::vector<std::pair<bitfield_idx_t, std::uint32_t>>{};
+  lookups.resize(1'000'000U);
+  for (auto& [bf, day] : lookups) {
+    bf = tt.transport_traffic_days_[transport_idx_t{transport_dist(rng)}];
+    day = day_dist(rng);
+  }
+
+  auto const measure = [&](char const* name, auto&& is_active) {
+    auto const start = std::chrono::steady_clock::now();
+    auto n_active = 0U;
+    for (auto i = 0U; i != kLookups; ++i) {
+      auto const& [bf, day] = lookups[i % lookups.size()];
+      n_active += is_active(bf, day) ? 1U : 0U;
+    }
+    auto const time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << name << ": "
+              << static_cast<double>(time.count()) / kLookups
+              << "ns/lookup (active=" << n_active << ")\n";
+  };
+  measure("raw test(day)", [&](bitfield_idx_t const bf, std::uint32_t day) {
+    return tt.bitfields_[bf].test(day);
+  });
+  measure("compressed test(day)",
+          [&](bitfield_idx_t const bf, std::uint32_t day) {
+            return compressed[bf].test(day);
+          });
+}
+
 int main(int argc, char* argv[]) {
   namespace bpo = boost::program_options;
 
@@ -333,11 +829,25 @@ int main(int argc, char* argv[]) {
   auto seed = std::int64_t{-1};
   auto min_transfer_time = duration_t::rep{};
   auto qa_path = std::filesystem::path{};
+  auto report_path = std::filesystem::path{};
+  auto baseline_path = std::filesystem::path{};
+  auto compare_path = std::filesystem::path{};
+  auto regression_threshold = 5.0;
+  auto perf_counters_enabled = false;
+  auto use_mmap = false;
+  auto bitfield_benchmark = false;
+  auto ls = load_settings{};
+  auto load_rates_str = std::string{};
+  auto rt_update_interval = std::chrono::milliseconds::rep{10'000};
 
   bpo::options_description desc("Allowed options");
   desc.add_options()("help,h", "produce this help message")  //
-      ("tt_path,p", bpo::value(&tt_path)->required(),
+      ("tt_path,p", bpo::value(&tt_path),
        "path to a binary file containing a serialized nigiri timetable")  //
+      ("mmap", bpo::bool_switch(&use_mmap),
+       "map the timetable file (shared page cache) instead of reading it")  //
+      ("bitfield_benchmark", bpo::bool_switch(&bitfield_benchmark),
+       "compare memory and lookup speed of raw and compressed bitfields")  //
       ("seed,s", bpo::value<std::int64_t>(&seed),
        "value to seed the RNG of the query generator with, "
        "omit for random seed")  //
@@ -406,7 +916,34 @@ int main(int argc, char* argv[]) {
       ("dest_loc", bpo::value<location_idx_t::value_t>(&dest_loc_val),
        "destination location for random queries")  //
       ("qa_path,q", bpo::value(&qa_path),
-       "path to write the journey criteria to for qa");
+       "path to write the journey criteria to for qa")  //
+      ("report,r", bpo::value(&report_path),
+       "path to write a JSON report (percentiles + histograms per metric)")  //
+      ("baseline", bpo::value(&baseline_path),
+       "JSON report of a previous run to compare against")  //
+      ("compare", bpo::value(&compare_path),
+       "compare this JSON report to --baseline without running queries")  //
+      ("regression_threshold",
+       bpo::value(&regression_threshold)->default_value(regression_threshold),
+       "percentile increase (in percent) reported as regression")  //
+      ("perf_counters", bpo::bool_switch(&perf_counters_enabled),
+       "collect CPU cycles and LLC misses per query (Linux only)")  //
+      ("load_rates", bpo::value(&load_rates_str),
+       "load test: replay queries with Poisson arrivals at these rates "
+       "(queries/s, comma separated, e.g. 10,50,100)")  //
+      ("arrival_trace", bpo::value(&ls.arrival_trace_),
+       "load test: replay queries at the timestamps (ms, one per line) of "
+       "this file")  //
+      ("load_threads",
+       bpo::value(&ls.n_threads_)->default_value(ls.n_threads_),
+       "load test: number of worker threads")  //
+      ("rt_share", bpo::value(&ls.rt_share_)->default_value(ls.rt_share_),
+       "load test: share of queries using the real-time timetable [0, 1]")  //
+      ("rt_update", bpo::value(&ls.rt_updates_)->composing(),
+       "load test: GTFS-RT protobuf files applied concurrently (cycled)")  //
+      ("rt_update_interval",
+       bpo::value(&rt_update_interval)->default_value(rt_update_interval),
+       "load test: milliseconds between GTFS-RT updates");
   bpo::variables_map vm;
   bpo::store(bpo::command_line_parser(argc, argv).options(desc).run(), vm);
 
@@ -418,10 +955,35 @@ int main(int argc, char* argv[]) {
 
   bpo::notify(vm);
 
+  if (vm.count("compare") != 0U) {
+    if (vm.count("baseline") == 0U) {
+      std::cout << "Error: --compare requires --baseline\n";
+      return 1;
+    }
+    return compare_reports(read_report(baseline_path),
+                           read_report(compare_path),
+                           regression_threshold) == 0U
+               ? 0
+               : 1;
+  }
+
+  if (vm.count("tt_path") == 0U) {
+    std::cout << "Error: please provide a timetable (--tt_path)\n";
+    return 1;
+  }
+
   std::cout << "loading timetable...\n";
-  auto tt = *nigiri::timetable::read(tt_path);
+  using tt_mem_t = std::variant<cista::wrapped<timetable>, mapped_timetable>;
+  auto tt_mem = use_mmap ? tt_mem_t{mapped_timetable::read(tt_path, {})}
+                         : tt_mem_t{timetable::read(tt_path)};
+  auto& tt = std::visit([](auto& x) -> timetable& { return *x; }, tt_mem);
   tt.resolve();
 
+  if (bitfield_benchmark) {
+    run_bitfield_benchmark(tt, seed);
+    return 0;
+  }
+
   gs.interval_size_ = duration_t{interval_size};
 
   if (!bbox_str.empty()) {
@@ -522,20 +1084,65 @@ int main(int argc, char* argv[]) {
   auto queries = std::vector<nigiri::query_generation::start_dest_query>{};
   generate_queries(queries, n_queries, tt, gs, seed);
 
+  if (!load_rates_str.empty() || !ls.arrival_trace_.empty()) {
+    if (!load_rates_str.empty()) {
+      for (auto const& rate :
+           tokenize(load_rates_str, ',',
+                    static_cast<std::uint32_t>(
+                        utl::count(load_rates_str, ',') + 1))) {
+        auto const r = std::stod(rate);
+        if (!std::isfinite(r) || r <= 0.0) {
+          std::cout << "Error: load rates must be positive (queries/s)\n";
+          return 1;
+        }
+        ls.rates_.emplace_back(r);
+      }
+    }
+    if (!(ls.rt_share_ >= 0.0 && ls.rt_share_ <= 1.0)) {
+      std::cout << "Error: rt_share must be in [0, 1]\n";
+      return 1;
+    }
+    ls.seed_ = seed;
+    ls.rt_update_interval_ = std::chrono::milliseconds{rt_update_interval};
+    run_load_test(queries, tt, ls);
+    print_memory_usage();
+    return 0;
+  }
+
   auto results = std::vector<benchmark_result>{};
-  process_queries(queries, results, tt);
+  process_queries(queries, results, tt, perf_counters_enabled);
+  if (results.empty()) {
+    std::cout << "no results\n";
+    return 1;
+  }
 
   print_results(queries, results, tt, gs, tt_path);
+  print_percentiles(results);
 
   print_memory_usage();
 
-  auto total = std::chrono::milliseconds{0U};
+  auto total = std::chrono::microseconds{0U};
   for (auto const& res : results) {
     total += res.total_time_;
   }
-  std::cout << "AVG: " << (static_cast<double>(total.count()) / results.size())
+  std::cout << "AVG: "
+            << (static_cast<double>(total.count()) / 1000.0 / results.size())
             << "ms\n";
 
+  auto n_regressions = 0U;
+  if (vm.count("report") != 0U || vm.count("baseline") != 0U) {
+    auto const report = make_report(results);
+    if (vm.count("report") != 0U) {
+      auto out = std::ofstream{report_path};
+      out << boost::json::serialize(report) << "\n";
+    }
+    if (vm.count("baseline") != 0U) {
+      std::cout << "\n--- comparison with " << baseline_path << " ---\n";
+      n_regressions = compare_reports(read_report(baseline_path), report,
+                                      regression_threshold);
+    }
+  }
+
   if (vm.count("qa_path")) {
     auto bm_crit = nigiri::qa::benchmark_criteria{};
     for (auto const& res : results) {
@@ -547,10 +1154,14 @@ int main(int argc, char* argv[]) {
             static_cast<double>(j.transfers_));
       }
       utl::sort(jc);
-      bm_crit.qc_.emplace_back(res.q_idx_, res.total_time_, jc);
+      bm_crit.qc_.emplace_back(
+          res.q_idx_,
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              res.total_time_),
+          jc);
     }
     bm_crit.write(qa_path);
   }
 
-  return 0;
+  return n_regressions == 0U ? 0 : 1;
 }
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -17,12 +18,19 @@ struct nigiri_transport {
 };
 typedef struct nigiri_transport nigiri_transport_t;
 
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+struct nigiri_footpath {
+  uint32_t target_location_idx;
+  uint32_t duration;
+};
+#else
 static uint32_t const kTargetBits = 23U;
 static uint32_t const kDurationBits = 8 * sizeof(uint32_t) - kTargetBits;
 struct nigiri_footpath {
   unsigned int target_location_idx : kTargetBits;
   unsigned int duration : kDurationBits;
 };
+#endif
 typedef struct nigiri_footpath nigiri_footpath_t;
 
 struct nigiri_location {
@@ -127,6 +135,27 @@ void nigiri_update_with_rt(nigiri_timetable_t const* t,
                                             void* context),
                            void* context);
 
+// Same as nigiri_update_with_rt but reads the protobuf from memory and only
+// reports events whose value changed since the previous update.
+void nigiri_update_with_rt_from_memory(nigiri_timetable_t const* t,
+                                       char const* gtfsrt_pb_buf,
+                                       size_t gtfsrt_pb_buf_len,
+                                       void (*callback)(nigiri_event_change_t,
+                                                        void* context),
+                                       void* context);
+
+// Same as nigiri_update_with_rt_from_memory but reports changes in batches of
+// up to batch_size events (batch_size == 0: one batch for the whole update).
+void nigiri_update_with_rt_from_memory_batched(
+    nigiri_timetable_t const* t,
+    char const* gtfsrt_pb_buf,
+    size_t gtfsrt_pb_buf_len,
+    uint32_t batch_size,
+    void (*callback)(nigiri_event_change_t const* changes,
+                     uint32_t n_changes,
+                     void* context),
+    void* context);
+
 nigiri_pareto_set_t* nigiri_get_journeys(nigiri_timetable_t const* t,
                                          uint32_t start_location_idx,
                                          uint32_t destination_location_idx,
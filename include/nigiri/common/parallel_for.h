@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace nigiri {
+
+// Executor provided by the caller (e.g. backed by its own thread pool) that
+// calls fn(0), ..., fn(n - 1), possibly concurrently, and returns when all
+// calls are done. nigiri does not start threads on its own in hot paths.
+using parallel_for_fn = std::function<void(
+    std::size_t n, std::function<void(std::size_t)> const& fn)>;
+
+// Uses the executor if one is set, otherwise runs on the calling thread.
+template <typename Fn>
+void parallel_for(parallel_for_fn const& executor,
+                  std::size_t const n,
+                  Fn&& fn) {
+  if (executor) {
+    executor(n, std::function<void(std::size_t)>{fn});
+  } else {
+    for (auto i = std::size_t{0U}; i != n; ++i) {
+      fn(i);
+    }
+  }
+}
+
+}  // namespace nigiri
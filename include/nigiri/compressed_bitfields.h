@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cassert>
+#include <cinttypes>
+
+#include "utl/get_or_create.h"
+#include "utl/helpers/algorithm.h"
+
+#include "nigiri/types.h"
+
+namespace nigiri {
+
+// Dictionary coded bitfields.
+//
+// Each bitfield is split into blocks of 64 days. Distinct blocks are stored
+// once and a bitfield is represented by the indices of its blocks. Typical
+// service calendars ("every weekday in a range except holidays") share most of
+// their blocks and all days outside of the timetable interval share the empty
+// block. Bitfields derived from another bitfield by switching off single days
+// (as done for real-time updates) only add at most one new block.
+//
+// test(day) is O(1): one lookup of the block index and one of the block.
+template <typename Idx>
+struct compressed_bitfields {
+  using block_t = std::uint64_t;
+  using block_idx_t = std::uint32_t;
+
+  static constexpr auto const kBlockBits = sizeof(block_t) * 8U;
+  static constexpr auto const kBlocks = kMaxDays / kBlockBits;
+  static_assert(kMaxDays % kBlockBits == 0U);
+  static_assert(sizeof(bitfield) == kBlocks * sizeof(block_t));
+
+  using block_indices_t = array<block_idx_t, kBlocks>;
+
+  struct view {
+    bool test(std::size_t const day) const {
+      assert(day < kMaxDays);
+      return ((*dict_)[(*blocks_)[day / kBlockBits]] >> (day % kBlockBits)) &
+             1U;
+    }
+
+    bool none() const {
+      return utl::all_of(*blocks_,
+                         [](block_idx_t const b) { return b == kEmpty; });
+    }
+
+    bool any() const { return !none(); }
+
+    bitfield to_bitfield() const {
+      auto bf = bitfield{};
+      for (auto i = 0U; i != kBlocks; ++i) {
+        bf.blocks_[i] = (*dict_)[(*blocks_)[i]];
+      }
+      return bf;
+    }
+
+    friend bool operator==(view const& a, bitfield const& b) {
+      for (auto i = 0U; i != kBlocks; ++i) {
+        if ((*a.dict_)[(*a.blocks_)[i]] != b.blocks_[i]) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    vector<block_t> const* dict_;
+    block_indices_t const* blocks_;
+  };
+
+  Idx add(bitfield const& bf) {
+    if (dict_.empty()) {
+      dict_.emplace_back(block_t{0U});
+      block_lookup_.emplace(block_t{0U}, kEmpty);
+    }
+
+    auto blocks = block_indices_t{};
+    for (auto i = 0U; i != kBlocks; ++i) {
+      auto const block = bf.blocks_[i];
+      blocks[i] = utl::get_or_create(block_lookup_, block, [&]() {
+        auto const idx = static_cast<block_idx_t>(dict_.size());
+        dict_.emplace_back(block);
+        return idx;
+      });
+    }
+
+    auto const idx = Idx{bitfields_.size()};
+    bitfields_.emplace_back(blocks);
+    return idx;
+  }
+
+  // Copy of bitfield `idx` with `day` switched off.
+  Idx add_without(Idx const idx, std::size_t const day) {
+    auto bf = (*this)[idx].to_bitfield();
+    bf.set(day, false);
+    return add(bf);
+  }
+
+  view operator[](Idx const idx) const {
+    return view{&dict_, &bitfields_[idx]};
+  }
+
+  // Cheap intersection test: identical blocks intersect unless empty,
+  // otherwise the blocks from the dictionary are compared.
+  bool intersects(Idx const a, Idx const b) const {
+    auto const& x = bitfields_[a];
+    auto const& y = bitfields_[b];
+    for (auto i = 0U; i != kBlocks; ++i) {
+      if (x[i] == kEmpty || y[i] == kEmpty) {
+        continue;
+      }
+      if (x[i] == y[i] || (dict_[x[i]] & dict_[y[i]]) != 0U) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::size_t size() const { return bitfields_.size(); }
+
+  bool empty() const { return bitfields_.empty(); }
+
+  std::size_t size_bytes() const {
+    return bitfields_.size() * sizeof(block_indices_t) +
+           dict_.size() * sizeof(block_t) +
+           block_lookup_.size() * (sizeof(block_t) + sizeof(block_idx_t));
+  }
+
+  static constexpr auto const kEmpty = block_idx_t{0U};
+
+  vector_map<Idx, block_indices_t> bitfields_;
+  vector<block_t> dict_;
+  hash_map<block_t, block_idx_t> block_lookup_;
+};
+
+template <typename Idx>
+compressed_bitfields<Idx> compress(vector_map<Idx, bitfield> const& bitfields) {
+  auto c = compressed_bitfields<Idx>{};
+  c.bitfields_.reserve(bitfields.size());
+  for (auto const& bf : bitfields) {
+    c.add(bf);
+  }
+  return c;
+}
+
+}  // namespace nigiri
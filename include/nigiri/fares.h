@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nigiri/routing/journey.h"
+#include "nigiri/routing/pareto_set.h"
 #include "nigiri/string_store.h"
 #include "nigiri/types.h"
 
@@ -140,8 +141,20 @@ struct fares {
   vecvec<area_set_idx_t, area_idx_t> area_sets_;
   vector_map<area_set_idx_t, string_idx_t> area_set_ids_;
   bool has_priority_{false};
+
+  // Lookup index for fare_leg_rules_ (see build_leg_rule_index):
+  // rule indices sorted by (network, from_area, to_area, index) and the
+  // sorted distinct concrete networks/areas referenced by any rule.
+  vector<std::uint32_t> leg_rules_by_key_;
+  vector<network_idx_t> concrete_networks_;
+  vector<area_idx_t> concrete_from_areas_;
+  vector<area_idx_t> concrete_to_areas_;
 };
 
+// Builds the fare leg rule lookup index. Has to be called again after
+// fare_leg_rules_ changed.
+void build_leg_rule_index(fares&);
+
 struct timetable;
 
 using effective_fare_leg_t = std::vector<routing::journey::leg const*>;
@@ -161,4 +174,11 @@ std::vector<fare_transfer> get_fares(timetable const&,
                                      rt_timetable const*,
                                      routing::journey const&);
 
+// Prices all journeys of a result set. Timeframe matches are shared
+// between the journeys.
+std::vector<std::vector<fare_transfer>> get_fares(
+    timetable const&,
+    rt_timetable const*,
+    pareto_set<routing::journey> const&);
+
 }  // namespace nigiri
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "geo/latlng.h"
 
 #include "nigiri/types.h"
@@ -8,6 +10,17 @@ namespace nigiri {
 
 struct timetable;
 
+// Rasterizes every flex area into a grid over its bounding box (built by
+// finalize). Grid cells are inside, outside or on the boundary of the area.
+void build_flex_area_index(timetable&);
+
+// Exact polygon tests are only done for positions in boundary cells.
 bool is_in_flex_area(timetable const&, flex_area_idx_t, geo::latlng const&);
 
+// Batch version: result[i] is set iff positions[i] is in the flex area.
+void is_in_flex_area(timetable const&,
+                     flex_area_idx_t,
+                     std::span<geo::latlng const> positions,
+                     bitvec& result);
+
 }  // namespace nigiri
\ No newline at end of file
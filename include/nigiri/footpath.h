@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstring>
+#include <tuple>
+
 #include "fmt/ostream.h"
 
 #include "utl/verify.h"
@@ -11,27 +14,40 @@
 
 namespace nigiri {
 
+// Target location + duration, bit-packed.
+//
+// Default: 32 bit (23 bit target, 9 bit duration) -> max. ~8.4M locations.
+// NIGIRI_LARGE_LOCATION_SPACE: 40 bit (31 bit target, 9 bit duration) stored
+// unaligned in 5 bytes -> footpath memory grows by 25% instead of doubling.
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+#pragma pack(push, 1)
+#endif
 struct footpath {
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+  using value_type = std::uint64_t;
+  static constexpr auto const kTotalBits = 40U;
+#else
   using value_type = location_idx_t::value_t;
   static constexpr auto const kTotalBits = 8 * sizeof(value_type);
-  static constexpr auto const kTargetBits = 23U;
-  static constexpr auto const kDurationBits = kTotalBits - kTargetBits;
-  static constexpr auto const kMaxDuration = duration_t{
-      std::numeric_limits<location_idx_t::value_t>::max() >> kTargetBits};
+#endif
+  static constexpr auto const kDurationBits = 9U;
+  static constexpr auto const kTargetBits = kTotalBits - kDurationBits;
+  static constexpr auto const kMaxDuration =
+      duration_t{(value_type{1U} << kDurationBits) - 1U};
   static constexpr auto const kMaxTarget =
-      std::numeric_limits<location_idx_t::value_t>::max() >> kDurationBits;
+      static_cast<location_idx_t::value_t>((value_type{1U} << kTargetBits) -
+                                           1U);
 
   footpath() = default;
 
-  footpath(location_idx_t::value_t const val) {
-    std::memcpy(this, &val, sizeof(value_type));
-  }
+  footpath(value_type const val) { set(val); }
 
-  footpath(location_idx_t const target, duration_t const duration)
-      : target_{target},
-        duration_{static_cast<value_type>(
-            (duration > kMaxDuration ? kMaxDuration : duration).count())} {
+  footpath(location_idx_t const target, duration_t const duration) {
     utl::verify(to_idx(target) < kMaxTarget, "station index overflow");
+    set(static_cast<value_type>(to_idx(target)) |
+        (static_cast<value_type>(
+             (duration > kMaxDuration ? kMaxDuration : duration).count())
+         << kTargetBits));
   }
 
   static auto cmp_by_duration() {
@@ -40,34 +56,66 @@ struct footpath {
     };
   }
 
-  location_idx_t target() const { return location_idx_t{target_}; }
-  duration_t duration() const { return duration_t{duration_}; }
+  location_idx_t target() const {
+    return location_idx_t{static_cast<location_idx_t::value_t>(
+        value() & ((value_type{1U} << kTargetBits) - 1U))};
+  }
+  duration_t duration() const {
+    return duration_t{static_cast<duration_t::rep>(value() >> kTargetBits)};
+  }
 
-  location_idx_t::value_t value() const {
-    return *reinterpret_cast<location_idx_t::value_t const*>(this);
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+  value_type value() const {
+    return static_cast<value_type>(lo_) | (static_cast<value_type>(hi_) << 32U);
   }
 
+  void set(value_type const val) {
+    lo_ = static_cast<std::uint32_t>(val);
+    hi_ = static_cast<std::uint8_t>(val >> 32U);
+  }
+#else
+  value_type value() const {
+    return *reinterpret_cast<value_type const*>(this);
+  }
+
+  void set(value_type const val) { std::memcpy(this, &val, sizeof(value_type)); }
+#endif
+
   friend std::ostream& operator<<(std::ostream& out, footpath const& fp) {
     return out << "(" << fp.target() << ", " << fp.duration() << ")";
   }
 
-  bool operator==(footpath const& o) const {
-    return target_ == o.target_ && duration_ == o.duration_;
-  }
+  bool operator==(footpath const& o) const { return value() == o.value(); }
   auto operator<=>(footpath const& o) const {
-    return std::tie(target_, duration_) <=> std::tie(o.target_, o.duration_);
+    return std::tuple{target(), duration()} <=>
+           std::tuple{o.target(), o.duration()};
   }
 
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+  std::uint32_t lo_;
+  std::uint8_t hi_;
+#else
   location_idx_t::value_t target_ : kTargetBits;
   location_idx_t::value_t duration_ : kDurationBits;
+#endif
 };
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+#pragma pack(pop)
+static_assert(sizeof(footpath) == 5U);
+#else
+static_assert(sizeof(footpath) == 4U);
+#endif
 
 static_assert(std::three_way_comparable<footpath>);
 
 template <std::size_t NMaxTypes>
 constexpr auto static_type_hash(footpath const*,
                                 cista::hash_data<NMaxTypes> h) noexcept {
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+  return h.combine(cista::hash("nigiri::footpath40"));
+#else
   return h.combine(cista::hash("nigiri::footpath"));
+#endif
 }
 
 template <typename Ctx>
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cinttypes>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "opentelemetry/metrics/meter.h"
+#include "opentelemetry/metrics/provider.h"
 #include "opentelemetry/trace/provider.h"
 #include "opentelemetry/trace/tracer.h"
 
@@ -14,4 +21,24 @@ get_otel_tracer() {
       "nigiri");
 }
 
+inline opentelemetry::nostd::shared_ptr<opentelemetry::metrics::Meter>
+get_otel_meter() {
+  return opentelemetry::metrics::Provider::GetMeterProvider()->GetMeter(
+      "nigiri");
+}
+
+// Adds every counter (e.g. from search_stats::to_map) as span attribute
+// "<prefix><name>".
+inline void set_span_attributes(
+    opentelemetry::trace::Span& span,
+    std::string_view prefix,
+    std::map<std::string, std::uint64_t> const& counters) {
+  auto key = std::string{prefix};
+  for (auto const& [name, value] : counters) {
+    key.resize(prefix.size());
+    key += name;
+    span.SetAttribute(key, value);
+  }
+}
+
 }  // namespace nigiri
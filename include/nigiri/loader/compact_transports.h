@@ -0,0 +1,23 @@
+#pragma once
+
+#include "nigiri/types.h"
+
+namespace nigiri {
+struct shapes_storage;
+struct timetable;
+}  // namespace nigiri
+
+namespace nigiri::loader {
+
+struct compaction_stats {
+  unsigned removed_transports_{0U};
+  unsigned removed_routes_{0U};
+};
+
+// Removes transports that never operate (empty traffic day bitfield, e.g.
+// duplicates disabled by merge_duplicates) and routes left without transports.
+// Transport and route indices are renumbered, keeping their relative order.
+// Route bounding boxes in `shapes` (if given) are renumbered accordingly.
+compaction_stats compact_transports(timetable&, shapes_storage* = nullptr);
+
+}  // namespace nigiri::loader
@@ -6,18 +6,20 @@
 #include "nigiri/loader/build_footpaths.h"
 
 namespace nigiri {
+struct shapes_storage;
 struct timetable;
-}
+}  // namespace nigiri
 
 namespace nigiri::loader {
 
 void register_special_stations(timetable&);
-void finalize(timetable&, finalize_options);
+void finalize(timetable&, finalize_options, shapes_storage* = nullptr);
 void finalize(timetable&,
               bool adjust_footpaths = false,
               bool merge_dupes_intra_src = false,
               bool merge_dupes_inter_src = false,
               std::uint16_t max_footpath_length =
-                  std::numeric_limits<std::uint16_t>::max());
+                  std::numeric_limits<std::uint16_t>::max(),
+              shapes_storage* = nullptr);
 
 }  // namespace nigiri::loader
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "utl/parallel_for.h"
+
+namespace nigiri::loader {
+
+// Splits services with the same route key into routes in which no service
+// overtakes another one: event times at every stop are non-decreasing modulo
+// one day (the same condition get_index checks).
+//
+// Services are sorted by their first departure once and then appended to a
+// compatible route. The compatible route whose last service departs latest is
+// chosen (best fit), a new route is opened only if no route fits. Services
+// are never inserted in the middle of a route, so the cost is O(n log n) for
+// sorting plus one comparison with the last service of every open route.
+template <typename Service>
+std::vector<std::vector<Service>> partition_routes(
+    std::vector<Service>&& services) {
+  auto const first_dep = [](Service const& s) {
+    return s.utc_times_.front() % 1440;
+  };
+
+  auto const fits_after = [](Service const& prev, Service const& s) {
+    for (auto i = 0U; i != s.utc_times_.size(); ++i) {
+      if (s.utc_times_[i] % 1440 < prev.utc_times_[i] % 1440) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Equal first departures: later services first (the order of inserting
+  // each service at its lower bound).
+  auto order = std::vector<std::uint32_t>(services.size());
+  std::iota(begin(order), end(order), 0U);
+  std::sort(begin(order), end(order),
+            [&](std::uint32_t const a, std::uint32_t const b) {
+              auto const dep_a = first_dep(services[a]);
+              auto const dep_b = first_dep(services[b]);
+              return dep_a < dep_b || (dep_a == dep_b && a > b);
+            });
+
+  auto routes = std::vector<std::vector<Service>>{};
+  for (auto const i : order) {
+    auto& s = services[i];
+    auto best = routes.size();
+    for (auto r = 0U; r != routes.size(); ++r) {
+      auto const& last = routes[r].back();
+      if (fits_after(last, s) &&
+          (best == routes.size() ||
+           first_dep(last) > first_dep(routes[best].back()))) {
+        best = r;
+      }
+    }
+    if (best == routes.size()) {
+      routes.emplace_back();
+    }
+    routes[best].emplace_back(std::move(s));
+  }
+
+  return routes;
+}
+
+// Partitions the services of all route keys in parallel.
+// Keeps the iteration order of the map.
+template <typename Map>
+auto partition_routes_by_key(Map& services_by_key) {
+  using key_t = typename Map::key_type;
+  using service_t = typename Map::mapped_type::value_type;
+
+  auto routes =
+      std::vector<std::pair<key_t, std::vector<std::vector<service_t>>>>{};
+  auto services = std::vector<std::vector<service_t>*>{};
+  routes.reserve(services_by_key.size());
+  services.reserve(services_by_key.size());
+  for (auto& [key, key_services] : services_by_key) {
+    routes.emplace_back(key, std::vector<std::vector<service_t>>{});
+    services.emplace_back(&key_services);
+  }
+
+  utl::parallel_for_run(routes.size(), [&](std::size_t const i) {
+    routes[i].second = partition_routes(std::move(*services[i]));
+  });
+
+  return routes;
+}
+
+}  // namespace nigiri::loader
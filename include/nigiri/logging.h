@@ -1,10 +1,13 @@
 #pragma once
 
 #include <chrono>
+#include <cinttypes>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 #include "fmt/core.h"
 #include "fmt/ostream.h"
@@ -57,6 +60,7 @@ void log(log_lvl const lvl,
 #include NIGIRI_LOG_HEADER
 #endif
 
+// Logs start and duration and traces the scope as OpenTelemetry span.
 struct scoped_timer final {
   explicit scoped_timer(std::string name);
   scoped_timer(scoped_timer const&) = delete;
@@ -65,8 +69,14 @@ struct scoped_timer final {
   scoped_timer& operator=(scoped_timer&&) = delete;
   ~scoped_timer();
 
+  // Adds a size/count attribute to the span.
+  void set_attribute(std::string_view key, std::uint64_t value) const;
+
+  struct span;
+
   std::string name_;
   std::chrono::time_point<std::chrono::steady_clock> start_;
+  std::unique_ptr<span> span_;
 };
 
 }  // namespace nigiri
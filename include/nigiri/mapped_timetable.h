@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <future>
+
+#include "nigiri/timetable.h"
+
+namespace nigiri {
+
+// Timetable deserialized in place from a private (copy-on-write) memory
+// mapping of the file written by timetable::write.
+//
+// All containers point directly into the mapping. Pages that are only read
+// (the bulk of the data: stop times, bitfields, footpaths, ...) stay backed by
+// the page cache and are shared between all processes mapping the same file.
+// Only pages that get written (pointer fix-ups during deserialization,
+// modifications by the user) become private copies.
+struct mapped_timetable {
+  enum class checksum_check : std::uint8_t {
+    kEager,  // verify before returning (reads the whole file once)
+    kBackground,  // verify in a background thread, see checksum_ok()
+    kSkip
+  };
+
+  struct options {
+    // MAP_POPULATE: pre-fault all pages (slower start, no page faults later).
+    bool populate_{false};
+
+    // MADV_WILLNEED (read ahead) instead of MADV_RANDOM.
+    bool will_need_{false};
+
+    checksum_check checksum_{checksum_check::kBackground};
+  };
+
+  static mapped_timetable read(std::filesystem::path const&, options const&);
+
+  mapped_timetable(mapped_timetable&&) noexcept;
+  mapped_timetable& operator=(mapped_timetable&&) noexcept;
+  mapped_timetable(mapped_timetable const&) = delete;
+  mapped_timetable& operator=(mapped_timetable const&) = delete;
+  ~mapped_timetable();
+
+  timetable& operator*() const { return *tt_; }
+  timetable* operator->() const { return tt_; }
+  timetable* get() const { return tt_; }
+
+  // Blocks until the background checksum verification (if any) finished.
+  // Returns true if the checksum matched or the check was skipped.
+  bool checksum_ok();
+
+private:
+  mapped_timetable() = default;
+  void unmap();
+
+  void* addr_{nullptr};
+  std::size_t size_{0U};
+#ifdef _WIN32
+  cista::buffer buf_;
+#endif
+  timetable* tt_{nullptr};
+  std::future<bool> checksum_ok_;
+};
+
+}  // namespace nigiri
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace nigiri::routing {
+struct search_stats;
+}  // namespace nigiri::routing
+
+namespace nigiri {
+
+// OpenTelemetry metrics (meter "nigiri") of the current global meter provider.
+// Instruments are recreated if the meter provider is replaced.
+
+// Query phase histograms (ms) and interval extensions of a finished search.
+void record_search_metrics(std::string_view algo, routing::search_stats const&);
+
+// Processing time of a real-time update (ms) and the lag between the feed
+// timestamp and its application (s). `kind` is "gtfsrt" or "vdv_aus".
+void record_rt_update_metrics(std::string_view kind,
+                              std::string_view tag,
+                              std::chrono::microseconds update_time,
+                              std::optional<std::chrono::seconds> lag);
+
+}  // namespace nigiri
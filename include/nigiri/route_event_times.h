@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <compare>
+#include <iterator>
+#include <span>
+
+#include "nigiri/common/linear_lower_bound.h"
+#include "nigiri/types.h"
+
+namespace nigiri {
+
+// Routes where all transports run the times of a template transport, only
+// shifted by a start offset (e.g. expanded GTFS frequencies), store the event
+// times of the template once. Their transports are grouped into windows of
+// evenly spaced departures: transport first_ + j of the route starts
+// start_ + j * headway_ minutes after the template.
+struct headway_window {
+  std::uint32_t first_;
+  std::uint16_t start_;
+  std::uint16_t headway_;
+};
+
+// Event times of all transports of a route at one stop (one entry per
+// transport, sorted by minutes after midnight). Headway routes compute the
+// times from the template, regular routes read them from route_stop_times_.
+struct route_event_times {
+  struct iterator {
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = delta;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = delta;
+
+    struct arrow {
+      delta const* operator->() const { return &d_; }
+      delta d_;
+    };
+
+    delta operator*() const { return (*events_)[idx_]; }
+    arrow operator->() const { return {**this}; }
+    delta operator[](difference_type const n) const {
+      return (*events_)[static_cast<std::size_t>(
+          static_cast<difference_type>(idx_) + n)];
+    }
+
+    iterator& operator+=(difference_type const n) {
+      idx_ = static_cast<std::size_t>(static_cast<difference_type>(idx_) + n);
+      return *this;
+    }
+    iterator& operator-=(difference_type const n) { return *this += -n; }
+    iterator& operator++() { return *this += 1; }
+    iterator& operator--() { return *this -= 1; }
+    iterator operator++(int) {
+      auto const tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    iterator operator--(int) {
+      auto const tmp = *this;
+      --*this;
+      return tmp;
+    }
+
+    friend iterator operator+(iterator it, difference_type const n) {
+      return it += n;
+    }
+    friend iterator operator+(difference_type const n, iterator it) {
+      return it += n;
+    }
+    friend iterator operator-(iterator it, difference_type const n) {
+      return it -= n;
+    }
+    friend difference_type operator-(iterator const a, iterator const b) {
+      return static_cast<difference_type>(a.idx_) -
+             static_cast<difference_type>(b.idx_);
+    }
+    friend bool operator==(iterator const a, iterator const b) {
+      return a.idx_ == b.idx_;
+    }
+    friend auto operator<=>(iterator const a, iterator const b) {
+      return a.idx_ <=> b.idx_;
+    }
+
+    route_event_times const* events_{nullptr};
+    std::size_t idx_{0U};
+  };
+
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  std::size_t size() const { return n_; }
+  bool empty() const { return n_ == 0U; }
+  bool is_headway() const { return !windows_.empty(); }
+
+  delta operator[](std::size_t const i) const {
+    if (windows_.empty()) {
+      return times_[i];
+    }
+    auto const w = std::prev(std::upper_bound(
+        windows_.begin(), windows_.end(), i,
+        [](std::size_t const a, headway_window const& b) {
+          return a < b.first_;
+        }));
+    return shift(w->start_ + static_cast<int>(i - w->first_) * w->headway_);
+  }
+
+  iterator begin() const { return {this, 0U}; }
+  iterator end() const { return {this, n_}; }
+  reverse_iterator rbegin() const { return reverse_iterator{end()}; }
+  reverse_iterator rend() const { return reverse_iterator{begin()}; }
+
+  friend iterator begin(route_event_times const& t) { return t.begin(); }
+  friend iterator end(route_event_times const& t) { return t.end(); }
+
+  // Position of the transport in the route.
+  static std::size_t index(iterator const it) { return it.idx_; }
+  static std::size_t index(reverse_iterator const it) {
+    return it.base().idx_ - 1U;
+  }
+
+  // First event at or after the given minute after midnight.
+  iterator lower_bound_mam(int const mam) const {
+    if (windows_.empty()) {
+      return linear_lb(begin(), end(), mam, [](delta const a, int const b) {
+        return a.mam() < b;
+      });
+    }
+    for (auto k = 0U; k != windows_.size(); ++k) {
+      auto const& w = windows_[k];
+      auto const first = static_cast<int>(shift(w.start_).mam());
+      if (first + (window_size(k) - 1) * w.headway_ < mam) {
+        continue;
+      }
+      auto const j =
+          mam <= first ? 0 : (mam - first + w.headway_ - 1) / w.headway_;
+      return {this, w.first_ + static_cast<std::size_t>(j)};
+    }
+    return end();
+  }
+
+  // First event after the given minute after midnight.
+  iterator upper_bound_mam(int const mam) const {
+    if (windows_.empty()) {
+      auto i = n_;
+      while (i != 0U && times_[i - 1U].mam() > mam) {
+        --i;
+      }
+      return {this, i};
+    }
+    for (auto k = 0U; k != windows_.size(); ++k) {
+      auto const& w = windows_[k];
+      auto const first = static_cast<int>(shift(w.start_).mam());
+      if (first + (window_size(k) - 1) * w.headway_ <= mam) {
+        continue;
+      }
+      auto const j = mam < first ? 0 : (mam - first) / w.headway_ + 1;
+      return {this, w.first_ + static_cast<std::size_t>(j)};
+    }
+    return end();
+  }
+
+  // Template time shifted by the given offset [minutes].
+  delta shift(int const offset) const {
+    auto const t = times_->days() * 1440 + times_->mam() + offset;
+    return delta{static_cast<std::uint16_t>(t / 1440),
+                 static_cast<std::uint16_t>(t % 1440)};
+  }
+
+  // Number of transports in the k-th window.
+  int window_size(std::size_t const k) const {
+    auto const to =
+        k + 1U == windows_.size() ? n_ : std::size_t{windows_[k + 1U].first_};
+    return static_cast<int>(to - windows_[k].first_);
+  }
+
+  // Regular route: the times of all transports.
+  // Headway route: the time of the template.
+  delta const* times_;
+  std::size_t n_;
+  std::span<headway_window const> windows_;
+};
+
+}  // namespace nigiri
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <span>
+#include <tuple>
+#include <utility>
+
+#include "utl/helpers/algorithm.h"
+
+#include "nigiri/routing/pareto_set.h"
+
+namespace nigiri {
+
+// Pareto set for small elements whose criteria are a few 16 bit integers
+// (smaller is better, returned by T::criteria()). T::dominates has to agree
+// with comparing all criteria with <=.
+//
+// Up to N elements are stored in place with their criteria in a
+// structure-of-arrays layout. Dominance tests against all elements are
+// branch-free loops over the fixed size columns that the compiler vectorizes
+// and adding elements does not allocate. Sets growing beyond N elements switch
+// to the generic pareto_set until they are cleared.
+template <typename T, std::size_t N>
+struct fixed_pareto_set {
+  using criteria_t = decltype(std::declval<T const&>().criteria());
+  static constexpr auto const kCriteria = std::tuple_size_v<criteria_t>;
+
+  bool add(T const& el) {
+    if (is_large_) {
+      return std::get<0>(large_.add(T{el}));
+    }
+
+    auto const c = el.criteria();
+    if (is_dominated(c)) {
+      return false;
+    }
+
+    auto dominated = std::array<std::uint8_t, N>{};
+    for (auto i = 0U; i != N; ++i) {
+      auto d = static_cast<std::uint8_t>(i < size_);
+      for (auto m = 0U; m != kCriteria; ++m) {
+        d &= static_cast<std::uint8_t>(c[m] <= criteria_[m][i]);
+      }
+      dominated[i] = d;
+    }
+
+    auto n = 0U;
+    for (auto i = 0U; i != size_; ++i) {
+      if (dominated[i] != 0U) {
+        continue;
+      }
+      if (n != i) {
+        els_[n] = els_[i];
+        for (auto m = 0U; m != kCriteria; ++m) {
+          criteria_[m][n] = criteria_[m][i];
+        }
+      }
+      ++n;
+    }
+    size_ = n;
+
+    if (size_ == N) {
+      is_large_ = true;
+      large_.clear();
+      for (auto i = 0U; i != size_; ++i) {
+        large_.add_not_optimal(els_[i]);
+      }
+      large_.add_not_optimal(el);
+      return true;
+    }
+
+    els_[size_] = el;
+    for (auto m = 0U; m != kCriteria; ++m) {
+      criteria_[m][size_] = c[m];
+    }
+    ++size_;
+    return true;
+  }
+
+  bool is_dominated(criteria_t const& c) const {
+    if (is_large_) {
+      return utl::any_of(large_, [&](T const& x) {
+        auto const xc = x.criteria();
+        for (auto m = 0U; m != kCriteria; ++m) {
+          if (xc[m] > c[m]) {
+            return false;
+          }
+        }
+        return true;
+      });
+    }
+
+    auto any = std::uint8_t{0U};
+    for (auto i = 0U; i != N; ++i) {
+      auto d = static_cast<std::uint8_t>(i < size_);
+      for (auto m = 0U; m != kCriteria; ++m) {
+        d &= static_cast<std::uint8_t>(criteria_[m][i] <= c[m]);
+      }
+      any |= d;
+    }
+    return any != 0U;
+  }
+
+  // Column of criterion m. Only valid while !is_large(). Entries at positions
+  // >= size() are unspecified.
+  std::array<std::uint16_t, N> const& criterion(std::size_t const m) const {
+    return criteria_[m];
+  }
+
+  std::span<T const> elements() const {
+    return is_large_ ? std::span<T const>{large_.els_}
+                     : std::span<T const>{els_.data(), size_};
+  }
+
+  auto begin() const { return elements().begin(); }
+  auto end() const { return elements().end(); }
+  friend auto begin(fixed_pareto_set const& s) { return s.begin(); }
+  friend auto end(fixed_pareto_set const& s) { return s.end(); }
+
+  std::size_t size() const { return is_large_ ? large_.size() : size_; }
+  bool empty() const { return size() == 0U; }
+  bool is_large() const { return is_large_; }
+
+  void clear() {
+    size_ = 0U;
+    is_large_ = false;
+    large_.clear();
+  }
+
+  std::array<std::array<std::uint16_t, N>, kCriteria> criteria_{};
+  std::array<T, N> els_{};
+  std::uint32_t size_{0U};
+  bool is_large_{false};
+  pareto_set<T> large_;
+};
+
+}  // namespace nigiri
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "nigiri/common/linear_lower_bound.h"
+#include <iterator>
+
 #include "nigiri/routing/raptor/debug.h"
 #include "nigiri/timetable.h"
 
@@ -19,9 +20,6 @@ transport get_earliest_transport(timetable const& tt,
                                  [[maybe_unused]] location_idx_t const l,
                                  Fn&& worse_than_dest) {
   constexpr auto const kFwd = SearchDir == direction::kForward;
-  constexpr auto const is_better = [](auto a, auto b) {
-    return kFwd ? a < b : a > b;
-  };
   constexpr auto const is_better_or_eq = [](auto a, auto b) {
     return kFwd ? a <= b : a >= b;
   };
@@ -48,11 +46,12 @@ transport get_earliest_transport(timetable const& tt,
   };
 
   auto const seek_first_day = [&]() {
-    return linear_lb(get_begin_it(event_times), get_end_it(event_times),
-                     mam_at_stop,
-                     [&](delta const a, minutes_after_midnight_t const b) {
-                       return is_better(a.mam(), b.count());
-                     });
+    if constexpr (kFwd) {
+      return event_times.lower_bound_mam(mam_at_stop.count());
+    } else {
+      return std::make_reverse_iterator(
+          event_times.upper_bound_mam(mam_at_stop.count()));
+    }
   };
 
   constexpr auto const kNDaysToIterate = day_idx_t::value_t{2U};
@@ -66,7 +65,7 @@ transport get_earliest_transport(timetable const& tt,
 
     auto const day = kFwd ? day_at_stop + i : day_at_stop - i;
     for (auto it = begin(ev_time_range); it != end(ev_time_range); ++it) {
-      auto const t_offset = static_cast<std::size_t>(&*it - event_times.data());
+      auto const t_offset = route_event_times::index(it);
       auto const ev = *it;
       auto const ev_mam = ev.mam();
 
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+#include "nigiri/for_each_meta.h"
 #include "nigiri/routing/journey.h"
 #include "nigiri/routing/limits.h"
 #include "nigiri/routing/pareto_set.h"
@@ -11,7 +18,12 @@ namespace nigiri::routing {
 
 template <direction SearchDir>
 struct interval_estimator {
-  explicit interval_estimator(timetable const& tt, query const& q)
+  // travel_time_lb: lower bound in minutes from each location to the
+  // destination (as computed for RAPTOR), empty if not available.
+  explicit interval_estimator(timetable const& tt,
+                              query const& q,
+                              std::span<std::uint16_t const> travel_time_lb =
+                                  {})
       : tt_{tt}, q_{q} {
 
     auto const start_itv = std::visit(
@@ -35,6 +47,8 @@ struct interval_estimator {
                 start_itv.from_ +
                 (start_itv.to_ - start_itv.from_ + kMaxSearchIntervalSize) /
                     2))};
+
+    init_connections_per_hour(travel_time_lb);
   }
 
   interval<unixtime_t> initial(interval<unixtime_t> const& itv) const {
@@ -44,7 +58,7 @@ struct interval_estimator {
     }
 
     auto new_itv = itv;
-    auto const ext = 1_hours * q_.min_connection_count_;
+    auto const n = q_.min_connection_count_;
 
     if (can_extend_bad_dir(itv)) {
       if constexpr (SearchDir == direction::kForward) {
@@ -53,23 +67,25 @@ struct interval_estimator {
         } else {
           new_itv.to_ += 1_hours;
         }
-        new_itv.to_ += ext;
+        new_itv.to_ += initial_extension(itv.to_, n, direction::kForward);
       } else {
         if (can_extend_later(itv)) {
           new_itv.to_ += 1_hours;
         } else {
           new_itv.from_ -= 1_hours;
         }
-        new_itv.from_ -= ext;
+        new_itv.from_ -= initial_extension(itv.from_, n, direction::kBackward);
       }
     } else {
       if constexpr (SearchDir == direction::kForward) {
         if (q_.extend_interval_earlier_) {
-          new_itv.from_ -= 1_hours + ext;
+          new_itv.from_ -=
+              1_hours + initial_extension(itv.from_, n, direction::kBackward);
         }
       } else {
         if (q_.extend_interval_later_) {
-          new_itv.to_ += 1_hours + ext;
+          new_itv.to_ +=
+              1_hours + initial_extension(itv.to_, n, direction::kForward);
         }
       }
     }
@@ -87,6 +103,35 @@ struct interval_estimator {
     }
 
     auto new_itv = itv;
+
+    // Expected time to find the missing connections, but at least doubling
+    // the interval to keep the number of extensions low if the estimate is
+    // too optimistic (transports that do not lead to the destination).
+    if (has_service_stats_) {
+      if (can_extend_both_dir(itv)) {
+        auto const n = (num_con_req + 1U) / 2U;
+        new_itv.from_ -=
+            std::max(expected_duration(itv.from_, n, direction::kBackward),
+                     itv.size() / 2);
+        new_itv.to_ +=
+            std::max(expected_duration(itv.to_, n, direction::kForward),
+                     itv.size() / 2);
+      } else {
+        if (q_.extend_interval_earlier_) {
+          new_itv.from_ -= std::max(
+              expected_duration(itv.from_, num_con_req, direction::kBackward),
+              itv.size());
+        }
+        if (q_.extend_interval_later_) {
+          new_itv.to_ += std::max(
+              expected_duration(itv.to_, num_con_req, direction::kForward),
+              itv.size());
+        }
+      }
+      clamp(new_itv);
+      return new_itv;
+    }
+
     auto const ext = itv.size() * num_con_req;
 
     if (can_extend_both_dir(itv)) {
@@ -107,6 +152,105 @@ struct interval_estimator {
   }
 
 private:
+  // Transports per hour of the day leaving the start (forward search) that
+  // can arrive at the destination: the destination's arrivals are shifted by
+  // the lower bound of the travel time between both. Backward search: the
+  // arrivals at the start and the destination's departures shifted back.
+  // Values are in 1/16 transports.
+  void init_connections_per_hour(
+      std::span<std::uint16_t const> const travel_time_lb) {
+    if (!q_.estimate_interval_from_services_ ||
+        tt_.location_hourly_departures_.empty()) {
+      return;
+    }
+
+    auto const sum = [&](std::vector<offset> const& offsets,
+                         location_match_mode const mode, bool const dep) {
+      auto const& hourly = dep ? tt_.location_hourly_departures_
+                               : tt_.location_hourly_arrivals_;
+      auto events = std::array<std::uint32_t, 24U>{};
+      for (auto const& o : offsets) {
+        for_each_meta(
+            tt_,
+            mode == location_match_mode::kExact
+                ? location_match_mode::kOnlyChildren
+                : mode,
+            o.target(), [&](location_idx_t const l) {
+              if (to_idx(l) >= hourly.size()) {
+                return;
+              }
+              for (auto h = 0U; h != 24U; ++h) {
+                events[h] += hourly[l][h];
+              }
+            });
+      }
+      return events;
+    };
+
+    auto lb = std::numeric_limits<std::uint16_t>::max();
+    for (auto const& o : q_.start_) {
+      for_each_meta(tt_, q_.start_match_mode_, o.target(),
+                    [&](location_idx_t const l) {
+                      if (to_idx(l) < travel_time_lb.size()) {
+                        lb = std::min(lb, travel_time_lb[to_idx(l)]);
+                      }
+                    });
+    }
+    auto const shift =
+        lb == std::numeric_limits<std::uint16_t>::max()
+            ? 0U
+            : static_cast<unsigned>((lb + 30U) / 60U % 24U);
+
+    constexpr auto const kFwd = SearchDir == direction::kForward;
+    auto const from = sum(q_.start_, q_.start_match_mode_, kFwd);
+    auto const to = sum(q_.destination_, q_.dest_match_mode_, !kFwd);
+    for (auto h = 0U; h != 24U; ++h) {
+      auto const other = kFwd ? (h + shift) % 24U : (h + 24U - shift) % 24U;
+      connections_per_hour_[h] = std::min(from[h], to[other]);
+      has_service_stats_ = has_service_stats_ || connections_per_hour_[h] != 0U;
+    }
+  }
+
+  // Time from t (in the given direction) until n connections are expected.
+  // Computed in 1/16 transports times minutes to stay in integers.
+  duration_t expected_duration(unixtime_t const t,
+                               std::uint32_t const n,
+                               direction const dir) const {
+    auto const max = data_type_max_interval_.size();
+    if (n == 0U) {
+      return duration_t{0};
+    }
+    auto remaining = std::uint64_t{n} * 16U * 60U;
+    auto d = duration_t{0};
+    while (d < max) {
+      auto const x = dir == direction::kForward ? t + d : t - d - 1_minutes;
+      auto const minute = x.time_since_epoch().count() % 1440;
+      auto const step = duration_t{
+          dir == direction::kForward ? 60 - minute % 60 : minute % 60 + 1};
+      auto const rate = std::uint64_t{
+          connections_per_hour_[static_cast<std::size_t>(minute / 60)]};
+      auto const in_step = rate * static_cast<std::uint64_t>(step.count());
+      if (in_step >= remaining) {
+        auto const rest = (remaining + rate - 1U) / rate;
+        return d + duration_t{static_cast<duration_t::rep>(rest)};
+      }
+      remaining -= in_step;
+      d += step;
+    }
+    return std::min(d, max);
+  }
+
+  // The margin accounts for transports that do not lead to an optimal
+  // connection. Without statistics: one hour per connection.
+  duration_t initial_extension(unixtime_t const t,
+                               std::uint32_t const n,
+                               direction const dir) const {
+    static constexpr auto const kServicesPerConnection = 2U;
+    return has_service_stats_
+               ? expected_duration(t, n * kServicesPerConnection, dir)
+               : 1_hours * n;
+  }
+
   bool can_extend_earlier(interval<unixtime_t> const& itv) const {
     return q_.extend_interval_earlier_ &&
            itv.from_ != tt_.external_interval().from_;
@@ -142,6 +286,8 @@ private:
   timetable const& tt_;
   query const& q_;
   interval<unixtime_t> data_type_max_interval_;
+  std::array<std::uint32_t, 24U> connections_per_hour_{};
+  bool has_service_stats_{false};
 };
 
 }  // namespace nigiri::routing
\ No newline at end of file
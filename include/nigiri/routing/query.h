@@ -97,6 +97,22 @@ struct query {
   double fastest_direct_factor_{1.0};
   bool slow_direct_{false};
   double fastest_slow_direct_factor_{2.0};
+
+  // false: results only carry the journey header (start time, destination
+  // time, destination, transfers). Legs can be reconstructed on demand for
+  // selected journeys (see reconstruct_legs in raptor_search.h).
+  // slow_direct_ requires legs and is ignored in this mode.
+  bool reconstruct_legs_{true};
+
+  // pong_search: compute the lower bounds of both directions concurrently
+  // on the executor of search_state::parallel_for_ (sequential if unset).
+  bool parallel_lower_bounds_{false};
+
+  // Size the initial search interval and its extensions by the number of
+  // departures per hour at the start and arrivals at the destination shifted
+  // by the travel time lower bound (see interval_estimator) instead of one
+  // hour per requested connection.
+  bool estimate_interval_from_services_{false};
 };
 
 }  // namespace nigiri::routing
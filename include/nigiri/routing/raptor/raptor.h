@@ -1,9 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <string_view>
 
 #include "nigiri/common/delta_t.h"
-#include "nigiri/common/linear_lower_bound.h"
 #include "nigiri/routing/journey.h"
 #include "nigiri/routing/limits.h"
 #include "nigiri/routing/pareto_set.h"
@@ -73,6 +74,7 @@ struct raptor {
   using algo_state_t = raptor_state;
   using algo_stats_t = raptor_stats;
 
+  static constexpr auto const kName = std::string_view{"raptor"};
   static constexpr bool kUseLowerBounds = true;
   static constexpr auto const kFwd = (SearchDir == direction::kForward);
   static constexpr auto const kBwd = (SearchDir == direction::kBackward);
@@ -118,7 +120,9 @@ struct raptor {
         n_locations_{tt_.n_locations()},
         n_routes_{tt.n_routes()},
         n_rt_transports_{Rt ? rtt->n_rt_transports() : 0U},
-        state_{state.resize(n_locations_, n_routes_, n_rt_transports_)},
+        n_rt_routes_{Rt ? rtt->n_rt_routes() : 0U},
+        state_{state.resize(
+            n_locations_, n_routes_, n_rt_transports_, n_rt_routes_)},
         tmp_{state_.get_tmp<Vias>()},
         best_{state_.get_best<Vias>()},
         round_times_{state.get_round_times<Vias>()},
@@ -157,6 +161,30 @@ struct raptor {
     round_times_.reset(kInvalidArray);
   }
 
+  // Keeps the arrivals of the departures searched so far while departures
+  // that are not allowed to see them are searched after reset_arrivals().
+  void save_arrivals() {
+    auto const n = n_round_time_entries();
+    state_.saved_round_times_storage_.resize(n);
+    std::copy_n(begin(state_.round_times_storage_), n,
+                begin(state_.saved_round_times_storage_));
+    saved_time_at_dest_ = time_at_dest_;
+  }
+
+  // Combines the saved arrivals with the current ones (best of both).
+  // Valid for departures that may see the labels of both searches.
+  void merge_arrivals() {
+    auto const n = n_round_time_entries();
+    auto& current = state_.round_times_storage_;
+    auto const& saved = state_.saved_round_times_storage_;
+    for (auto i = 0U; i != n; ++i) {
+      current[i] = get_best(current[i], saved[i]);
+    }
+    for (auto k = 0U; k != time_at_dest_.size(); ++k) {
+      time_at_dest_[k] = get_best(time_at_dest_[k], saved_time_at_dest_[k]);
+    }
+  }
+
   void next_start_time() {
     utl::fill(best_, kInvalidArray);
     utl::fill(tmp_, kInvalidArray);
@@ -165,6 +193,7 @@ struct raptor {
     utl::fill(state_.route_mark_.blocks_, 0U);
     if constexpr (Rt) {
       utl::fill(state_.rt_transport_mark_.blocks_, 0U);
+      utl::fill(state_.rt_route_mark_.blocks_, 0U);
     }
   }
 
@@ -214,10 +243,10 @@ struct raptor {
           state_.route_mark_.set(to_idx(r), true);
         }
         if constexpr (Rt) {
-          for (auto const& rt_t :
-               rtt_->location_rt_transports_[location_idx_t{i}]) {
+          for (auto const& rt_r :
+               rtt_->location_rt_routes_[location_idx_t{i}]) {
             any_marked = true;
-            state_.rt_transport_mark_.set(to_idx(rt_t), true);
+            state_.rt_route_mark_.set(to_idx(rt_r), true);
           }
         }
       });
@@ -272,6 +301,7 @@ struct raptor {
 
       utl::fill(state_.route_mark_.blocks_, 0U);
       utl::fill(state_.rt_transport_mark_.blocks_, 0U);
+      utl::fill(state_.rt_route_mark_.blocks_, 0U);
 
       std::swap(state_.prev_station_mark_, state_.station_mark_);
       utl::fill(state_.station_mark_.blocks_, 0U);
@@ -311,13 +341,19 @@ struct raptor {
     });
   }
 
-  void reconstruct(query const& q, journey& j) {
+  void reconstruct(query const& q, journey& j, bool const finalize = true) {
     if constexpr (SearchMode == search_mode::kOneToAll) {
       return;
     }
     trace("reconstruct({} - {}, {} transfers", j.departure_time(),
           j.arrival_time(), j.transfers_);
-    reconstruct_journey<SearchDir>(tt_, rtt_, q, state_, j, base(), base_);
+    reconstruct_journey<SearchDir>(tt_, rtt_, q, state_, j, base(), base_,
+                                   finalize);
+  }
+
+  // Deferred part of reconstruct(q, j, false), see finalize_journey.
+  void finalize(query const& q, journey& j) const {
+    finalize_journey<SearchDir>(tt_, rtt_, q, j);
   }
 
 private:
@@ -325,6 +361,10 @@ private:
     return tt_.internal_interval_days().from_ + as_int(base_) * date::days{1};
   }
 
+  std::size_t n_round_time_entries() const {
+    return std::size_t{n_locations_} * (Vias + 1U) * (kMaxTransfers + 2U);
+  }
+
   template <bool WithClaszFilter, bool WithBikeFilter, bool WithCarFilter>
   bool loop_routes(unsigned const k) {
     auto any_marked = false;
@@ -379,6 +419,10 @@ private:
 
   template <bool WithClaszFilter, bool WithBikeFilter, bool WithCarFilter>
   bool loop_rt_routes(unsigned const k) {
+    state_.rt_route_mark_.for_each_set_bit([&](auto const rt_r_idx) {
+      mark_rt_route_transports(k, rt_route_idx_t{rt_r_idx});
+    });
+
     auto any_marked = false;
     state_.rt_transport_mark_.for_each_set_bit([&](auto const rt_t_idx) {
       auto const rt_t = rt_transport_idx_t{rt_t_idx};
@@ -431,6 +475,58 @@ private:
     return any_marked;
   }
 
+  // Marks the transports of an RT route that a route scan would board: the
+  // earliest boardable transport at every marked stop. Transports of an RT
+  // route do not overtake each other, so later ones cannot improve arrivals.
+  void mark_rt_route_transports(unsigned const k, rt_route_idx_t const r) {
+    auto const transports = rtt_->rt_route_transports_.at(r);
+    if constexpr (Vias != 0U) {
+      for (auto const rt_t : transports) {
+        state_.rt_transport_mark_.set(to_idx(rt_t), true);
+      }
+      return;
+    }
+
+    auto const stop_seq = rtt_->rt_route_location_seq_[r];
+    auto const ev_type = kFwd ? event_type::kDep : event_type::kArr;
+    for (auto i = 0U; i != stop_seq.size(); ++i) {
+      auto const stop_idx =
+          static_cast<stop_idx_t>(kFwd ? i : stop_seq.size() - i - 1U);
+      auto const stp = stop{stop_seq[stop_idx]};
+      auto const l_idx = cista::to_idx(stp.location_idx());
+      if (lb_[l_idx] == kUnreachable) {
+        break;
+      }
+
+      if (i == stop_seq.size() - 1U ||
+          !stp.can_start<SearchDir>(is_wheelchair_) ||
+          !state_.prev_station_mark_[l_idx]) {
+        continue;
+      }
+
+      auto const prev_round_time = round_times_[k - 1][l_idx][0];
+      if constexpr (kFwd) {
+        auto const it = std::lower_bound(
+            transports.begin(), transports.end(), prev_round_time,
+            [&](rt_transport_idx_t const rt_t, delta_t const t) {
+              return rt_time_at_stop(rt_t, stop_idx, ev_type) < t;
+            });
+        if (it != transports.end()) {
+          state_.rt_transport_mark_.set(to_idx(*it), true);
+        }
+      } else {
+        auto const it = std::upper_bound(
+            transports.begin(), transports.end(), prev_round_time,
+            [&](delta_t const t, rt_transport_idx_t const rt_t) {
+              return t < rt_time_at_stop(rt_t, stop_idx, ev_type);
+            });
+        if (it != transports.begin()) {
+          state_.rt_transport_mark_.set(to_idx(*std::prev(it)), true);
+        }
+      }
+    }
+  }
+
   void update_transfers(unsigned const k) {
     state_.prev_station_mark_.for_each_set_bit([&](auto&& i) {
       for (auto v = 0U; v != Vias + 1; ++v) {
@@ -1100,11 +1196,12 @@ private:
         r, stop_idx, kFwd ? event_type::kDep : event_type::kArr);
 
     auto const seek_first_day = [&]() {
-      return linear_lb(get_begin_it(event_times), get_end_it(event_times),
-                       mam_at_stop,
-                       [&](delta const a, minutes_after_midnight_t const b) {
-                         return is_better(a.mam(), b.count());
-                       });
+      if constexpr (kFwd) {
+        return event_times.lower_bound_mam(mam_at_stop.count());
+      } else {
+        return std::make_reverse_iterator(
+            event_times.upper_bound_mam(mam_at_stop.count()));
+      }
     };
 
     trace("┊ │k={}    et: current_best_at_stop={}, stop_idx={}, location={}\n",
@@ -1122,8 +1219,7 @@ private:
 
       auto const day = kFwd ? day_at_stop + i : day_at_stop - i;
       for (auto it = begin(ev_time_range); it != end(ev_time_range); ++it) {
-        auto const t_offset =
-            static_cast<std::size_t>(&*it - event_times.data());
+        auto const t_offset = route_event_times::index(it);
         auto const ev = *it;
         auto const ev_mam = ev.mam();
 
@@ -1245,7 +1341,7 @@ private:
   timetable const& tt_;
   rt_timetable const* rtt_{nullptr};
   int n_days_;
-  std::uint32_t n_locations_, n_routes_, n_rt_transports_;
+  std::uint32_t n_locations_, n_routes_, n_rt_transports_, n_rt_routes_;
   raptor_state& state_;
   bitvec end_reachable_;
   std::span<std::array<delta_t, Vias + 1>> tmp_;
@@ -1258,6 +1354,7 @@ private:
   std::vector<std::uint16_t> const& lb_;
   std::vector<via_stop> const& via_stops_;
   std::array<delta_t, kMaxTransfers + 2> time_at_dest_;
+  std::array<delta_t, kMaxTransfers + 2> saved_time_at_dest_;
   day_idx_t base_;
   raptor_stats stats_;
   clasz_mask_t allowed_claszes_;
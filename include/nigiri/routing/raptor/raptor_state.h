@@ -29,7 +29,8 @@ struct raptor_state {
 
   raptor_state& resize(unsigned n_locations,
                        unsigned n_routes,
-                       unsigned n_rt_transports);
+                       unsigned n_rt_transports,
+                       unsigned n_rt_routes);
 
   template <via_offset_t Vias>
   void print(timetable const& tt, date::sys_days, delta_t invalid);
@@ -85,10 +86,12 @@ struct raptor_state {
   std::vector<delta_t> tmp_storage_;
   std::vector<delta_t> best_storage_;
   std::vector<delta_t> round_times_storage_;
+  std::vector<delta_t> saved_round_times_storage_;
   bitvec station_mark_;
   bitvec prev_station_mark_;
   bitvec route_mark_;
   bitvec rt_transport_mark_;
+  bitvec rt_route_mark_;
 };
 
 }  // namespace nigiri::routing
@@ -21,7 +21,17 @@ void reconstruct_journey(timetable const&,
                          raptor_state const&,
                          journey&,
                          date::sys_days const base,
-                         day_idx_t const base_day_idx);
+                         day_idx_t const base_day_idx,
+                         bool finalize = true);
+
+// Footpath optimization and time-dependent offsets of a reconstructed
+// journey. Independent of the search state: can be deferred until the
+// search results are final (reconstruct_journey with finalize=false).
+template <direction SearchDir>
+void finalize_journey(timetable const&,
+                      rt_timetable const*,
+                      query const&,
+                      journey&);
 
 template <direction SearchDir>
 void optimize_footpaths(timetable const&,
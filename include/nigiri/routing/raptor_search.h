@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "nigiri/routing/raptor/raptor.h"
 #include "nigiri/routing/search.h"
 #include "nigiri/timetable.h"
@@ -15,4 +17,19 @@ routing_result raptor_search(
     direction search_dir,
     std::optional<std::chrono::seconds> timeout = std::nullopt);
 
+// Reconstructs the legs of journeys found by a search with
+// `query::reconstruct_legs_ = false` (same query and direction). Each journey
+// is searched again for its exact start time. Journeys that can not be
+// reconstructed are marked with `error_`. Runs on the calling thread with the
+// given states; to reconstruct in parallel, call it for disjoint parts of the
+// journeys with one pair of states per thread. The states must not be the
+// ones holding the journeys.
+void reconstruct_legs(timetable const&,
+                      rt_timetable const*,
+                      search_state&,
+                      raptor_state&,
+                      query const&,
+                      direction search_dir,
+                      std::span<journey> journeys);
+
 }  // namespace nigiri::routing
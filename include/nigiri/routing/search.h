@@ -10,9 +10,11 @@
 #include "utl/timing.h"
 #include "utl/to_vec.h"
 
+#include "nigiri/common/parallel_for.h"
 #include "nigiri/for_each_meta.h"
 #include "nigiri/get_otel_tracer.h"
 #include "nigiri/logging.h"
+#include "nigiri/otel_metrics.h"
 #include "nigiri/routing/dijkstra.h"
 #include "nigiri/routing/direct.h"
 #include "nigiri/routing/get_fastest_direct.h"
@@ -43,6 +45,32 @@ struct search_state {
   std::vector<std::uint16_t> dist_to_dest_;
   std::vector<start> starts_;
   pareto_set<journey> results_;
+
+  // Executor for finalizing many results (footpath optimization etc.), e.g.
+  // backed by a thread pool of the caller. Default: searching thread only.
+  parallel_for_fn parallel_for_;
+
+  // Clears the results but keeps their leg buffers for reuse.
+  void clear_results() {
+    for (auto& j : results_) {
+      if (j.legs_.capacity() != 0U) {
+        j.legs_.clear();
+        leg_buffers_.emplace_back(std::move(j.legs_));
+      }
+    }
+    results_.clear();
+  }
+
+  // Hands a leg buffer of a previous result to a journey before its legs are
+  // reconstructed. Results moved out by the caller take their buffer along.
+  void reuse_leg_buffer(journey& j) {
+    if (j.legs_.capacity() == 0U && !leg_buffers_.empty()) {
+      j.legs_ = std::move(leg_buffers_.back());
+      leg_buffers_.pop_back();
+    }
+  }
+
+  std::vector<std::vector<journey::leg>> leg_buffers_;
 };
 
 struct search_stats {
@@ -52,6 +80,9 @@ struct search_stats {
         {"fastest_direct", fastest_direct_},
         {"interval_extensions", interval_extensions_},
         {"execute_time", execute_time_.count()},
+        {"start_label_time_us", start_label_time_.count()},
+        {"algo_time_us", algo_time_.count()},
+        {"reconstruct_time_us", reconstruct_time_.count()},
         {"n_events_skipped_by_early_termination",
          n_events_skipped_by_early_termination_},
         {"search_interval_reduction_by_early_termination",
@@ -63,6 +94,9 @@ struct search_stats {
   std::uint64_t fastest_direct_{0ULL};
   std::uint64_t interval_extensions_{0ULL};
   std::chrono::milliseconds execute_time_{0LL};
+  std::chrono::microseconds start_label_time_{0LL};
+  std::chrono::microseconds algo_time_{0LL};
+  std::chrono::microseconds reconstruct_time_{0LL};
   std::uint64_t n_events_skipped_by_early_termination_{0ULL};
   std::chrono::minutes search_interval_reduction_by_early_termination_{0LL};
 };
@@ -79,6 +113,15 @@ struct search {
   using algo_state_t = typename Algo::algo_state_t;
   static constexpr auto const kFwd = (SearchDir == direction::kForward);
   static constexpr auto const kBwd = (SearchDir == direction::kBackward);
+  static constexpr auto const kDeferFinalize =
+      requires(Algo const& a, query const& q, journey& j) {
+        a.finalize(q, j);
+      };
+  static constexpr auto const kMinParallelFinalize = 32U;
+  static constexpr auto const kKeepArrivals = requires(Algo& a) {
+    a.save_arrivals();
+    a.merge_arrivals();
+  };
 
   Algo init(clasz_mask_t const allowed_claszes,
             bool const require_bikes_allowed,
@@ -202,14 +245,18 @@ struct search {
     auto span = get_otel_tracer()->StartSpan("search::execute");
     auto scope = opentelemetry::trace::Scope{span};
 
-    state_.results_.clear();
+    state_.clear_results();
 
     if (start_dest_overlap()) {
       return {&state_.results_, search_interval_, stats_,
               algo_.get_stats().to_map()};
     }
 
-    auto const itv_est = interval_estimator<SearchDir>{tt_, q_};
+    auto const itv_est = interval_estimator<SearchDir>{
+        tt_, q_,
+        Algo::kUseLowerBounds
+            ? std::span<std::uint16_t const>{state_.travel_time_lower_bound_}
+            : std::span<std::uint16_t const>{}};
     if (is_pretrip()) {
       search_interval_ = itv_est.initial(search_interval_);
     }
@@ -293,8 +340,7 @@ struct search {
                          kBwd);
         if constexpr (kBwd) {
           trace("dir=BWD, interval extension earlier -> reset state\n");
-          algo_.reset_arrivals();
-          remove_ontrip_results();
+          reset_arrivals(search_interval_.from_);
         }
       }
 
@@ -302,9 +348,8 @@ struct search {
         add_start_labels(interval{search_interval_.to_, new_interval.to_},
                          kFwd);
         if constexpr (kFwd) {
-          trace("dir=BWD, interval extension later -> reset state\n");
-          algo_.reset_arrivals();
-          remove_ontrip_results();
+          trace("dir=FWD, interval extension later -> reset state\n");
+          reset_arrivals(search_interval_.to_);
         }
       }
 
@@ -319,8 +364,14 @@ struct search {
                j.travel_time() >= fastest_direct_ ||
                j.travel_time() > q_.max_travel_time_;
       });
+    }
 
-      if (q_.slow_direct_) {
+    if (q_.reconstruct_legs_) {
+      finalize_results();
+    }
+
+    if (is_pretrip()) {
+      if (q_.slow_direct_ && q_.reconstruct_legs_) {
         auto direct = std::vector<journey>{};
         auto done = hash_set<std::pair<location_idx_t, location_idx_t>>{};
         for (auto const& j : state_.results_) {
@@ -349,15 +400,29 @@ struct search {
       });
     }
 
-    utl::erase_if(state_.results_, [&](auto&& j) { return j.legs_.empty(); });
+    if (q_.reconstruct_legs_) {
+      utl::erase_if(state_.results_,
+                    [&](auto&& j) { return j.legs_.empty(); });
+    } else {
+      utl::erase_if(state_.results_,
+                    [&](auto&& j) { return !is_result_candidate(j); });
+    }
 
     stats_.execute_time_ =
         std::chrono::duration_cast<std::chrono::milliseconds>(
             (std::chrono::steady_clock::now() - processing_start_time));
+
+    auto algo_stats = algo_.get_stats().to_map();
+    span->SetAttribute("nigiri.search.algo", Algo::kName);
+    span->SetAttribute("nigiri.search.n_results", state_.results_.size());
+    set_span_attributes(*span, "nigiri.search.", stats_.to_map());
+    set_span_attributes(*span, "nigiri.algo.", algo_stats);
+    record_search_metrics(Algo::kName, stats_);
+
     return {.journeys_ = &state_.results_,
             .interval_ = search_interval_,
             .search_stats_ = stats_,
-            .algo_stats_ = algo_.get_stats().to_map()};
+            .algo_stats_ = std::move(algo_stats)};
   }
 
 private:
@@ -416,6 +481,7 @@ private:
 
   void add_start_labels(start_time_t const& start_interval,
                         bool const add_ontrip) {
+    auto const start = std::chrono::steady_clock::now();
     state_.starts_.reserve(500'000);
     get_starts(SearchDir, tt_, rtt_, start_interval, q_.start_, q_.td_start_,
                q_.via_stops_, q_.max_start_offset_, q_.start_match_mode_,
@@ -424,6 +490,54 @@ private:
     std::sort(
         begin(state_.starts_), end(state_.starts_),
         [&](start const& a, start const& b) { return kFwd ? b < a : a < b; });
+    stats_.start_label_time_ += elapsed_us(start);
+  }
+
+  static std::chrono::microseconds elapsed_us(
+      std::chrono::steady_clock::time_point const start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+  }
+
+  bool is_result_candidate(journey const& j) const {
+    return (is_ontrip() || search_interval_.contains(j.start_time_)) &&
+           j.travel_time() < fastest_direct_;
+  }
+
+  void reconstruct(journey& j) {
+    state_.reuse_leg_buffer(j);
+    j.legs_.reserve(2U * j.transfers_ + 3U);
+    if constexpr (kDeferFinalize) {
+      algo_.reconstruct(q_, j, false);
+    } else {
+      algo_.reconstruct(q_, j);
+    }
+  }
+
+  // Footpath optimization etc. only for journeys that survived the search
+  // (pareto dominance, interval and travel time filters).
+  void finalize_results() {
+    if constexpr (kDeferFinalize) {
+      auto const start = std::chrono::steady_clock::now();
+      auto& results = state_.results_.els_;
+      auto const finalize = [&](std::size_t const i) {
+        auto& j = results[i];
+        if (j.legs_.empty() || j.error_) {
+          return;
+        }
+        try {
+          algo_.finalize(q_, j);
+        } catch (std::exception const& e) {
+          j.error_ = true;
+          log(log_lvl::error, "search", "finalize failed: {}", e.what());
+        }
+      };
+      parallel_for(results.size() < kMinParallelFinalize
+                       ? parallel_for_fn{}
+                       : state_.parallel_for_,
+                   results.size(), finalize);
+      stats_.reconstruct_time_ += elapsed_us(start);
+    }
   }
 
   void remove_ontrip_results() {
@@ -432,6 +546,32 @@ private:
     });
   }
 
+  // Departures added on the side of the interval the search runs towards
+  // must not see the labels of the interval searched so far. With algorithms
+  // supporting it, these labels are kept and merged back as soon as the new
+  // departures are done (see search_interval). Departures added later on the
+  // other side then continue from the labels of all previous departures.
+  void reset_arrivals(unixtime_t const boundary) {
+    if constexpr (kKeepArrivals) {
+      if (!merge_arrivals_pending_) {
+        algo_.save_arrivals();
+      }
+      merge_arrivals_pending_ = true;
+      merge_boundary_ = boundary;
+    }
+    algo_.reset_arrivals();
+    remove_ontrip_results();
+  }
+
+  void merge_arrivals() {
+    if constexpr (kKeepArrivals) {
+      if (merge_arrivals_pending_) {
+        algo_.merge_arrivals();
+        merge_arrivals_pending_ = false;
+      }
+    }
+  }
+
   void search_interval() {
     auto span = get_otel_tracer()->StartSpan("search::search_interval");
     auto scope = opentelemetry::trace::Scope{span};
@@ -449,8 +589,14 @@ private:
             return;
           }
 
-          algo_.next_start_time();
           auto const start_time = from_it->time_at_start_;
+          if (merge_arrivals_pending_ &&
+              (kFwd ? start_time < merge_boundary_
+                    : start_time >= merge_boundary_)) {
+            merge_arrivals();
+          }
+
+          algo_.next_start_time();
           for (auto const& s : it_range{from_it, to_it}) {
             trace("init: time_at_start={}, time_at_stop={} at {}\n",
                   s.time_at_start_, s.time_at_stop_, loc{tt_, s.stop_});
@@ -466,15 +612,19 @@ private:
               start_time + (kFwd ? 1 : -1) *
                                (std::min(fastest_direct_, q_.max_travel_time_) +
                                 duration_t{1});
+          auto const algo_start = std::chrono::steady_clock::now();
           algo_.execute(start_time, q_.max_transfers_, worst_time_at_dest,
                         q_.prf_idx_, state_.results_);
+          auto const reconstruct_start = std::chrono::steady_clock::now();
+          stats_.algo_time_ +=
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  reconstruct_start - algo_start);
 
           for (auto& j : state_.results_) {
-            if (j.legs_.empty() && !j.error_ &&
-                (is_ontrip() || search_interval_.contains(j.start_time_)) &&
-                j.travel_time() < fastest_direct_) {
+            if (q_.reconstruct_legs_ && j.legs_.empty() && !j.error_ &&
+                is_result_candidate(j)) {
               try {
-                algo_.reconstruct(q_, j);
+                reconstruct(j);
               } catch (std::exception const& e) {
                 j.error_ = true;
                 log(log_lvl::error, "search", "reconstruct failed: {}",
@@ -488,6 +638,7 @@ private:
               }
             }
           }
+          stats_.reconstruct_time_ += elapsed_us(reconstruct_start);
 
           if (q_.min_connection_count_ > 0 &&
               n_results_in_interval() >= q_.min_connection_count_ &&
@@ -506,6 +657,7 @@ private:
                 std::chrono::abs(start_size - search_interval_.size());
           }
         });
+    merge_arrivals();
   }
 
   timetable const& tt_;
@@ -517,6 +669,8 @@ private:
   duration_t fastest_direct_;
   Algo algo_;
   std::optional<std::chrono::seconds> timeout_;
+  bool merge_arrivals_pending_{false};
+  unixtime_t merge_boundary_;
 };
 
 }  // namespace nigiri::routing
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string_view>
+
 #include "nigiri/routing/journey.h"
 #include "nigiri/routing/pareto_set.h"
 #include "nigiri/routing/query.h"
@@ -76,6 +78,7 @@ struct query_engine {
   using algo_state_t = query_state;
   using algo_stats_t = query_stats;
 
+  static constexpr auto const kName = std::string_view{"tb"};
   static constexpr bool kUseLowerBounds = UseLowerBounds;
   static constexpr auto const kUnreachable =
       std::numeric_limits<std::uint16_t>::max();
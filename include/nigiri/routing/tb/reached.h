@@ -1,5 +1,6 @@
 #pragma once
 
+#include "nigiri/routing/fixed_pareto_set.h"
 #include "nigiri/routing/raptor/debug.h"
 #include "nigiri/routing/tb/segment_info.h"
 #include "nigiri/routing/tb/settings.h"
@@ -34,18 +35,23 @@ struct entry {
            segment_offset_ <= o.segment_offset_;
   }
 
+  inline std::array<std::uint16_t, 3U> criteria() const {
+    return {static_cast<std::uint16_t>(k_), transport_,
+            static_cast<std::uint16_t>(segment_offset_)};
+  }
+
   transport_t transport_;
   std::uint16_t segment_offset_ : 12;
   std::uint16_t k_ : 4;
 };
 
 struct reached {
+  // Most sets stay small (see the max_pareto_set_size statistic).
+  static constexpr auto const kInlineEntries = std::size_t{8U};
+  using set_t = fixed_pareto_set<entry, kInlineEntries>;
+
   explicit reached(timetable const& tt, tb_data const& tbd)
-      : tt_{tt}, tbd_{tbd}, data_{tt.n_routes()} {
-    for (auto& x : data_) {
-      x.els_.reserve(8);
-    }
-  }
+      : tt_{tt}, tbd_{tbd}, data_{tt.n_routes()} {}
 
   void reset() {
     for (auto r = route_idx_t{0U}; r != tt_.n_routes(); ++r) {
@@ -83,7 +89,21 @@ struct reached {
 
     auto min_segment =
         static_cast<std::uint16_t>(tt_.route_location_seq_[r].size() - 1);
-    for (auto const& re : data_[r]) {
+
+    auto const& s = data_[r];
+    if (!s.is_large()) {
+      auto const& ks = s.criterion(0U);
+      auto const& transports = s.criterion(1U);
+      auto const& segments = s.criterion(2U);
+      auto const n = s.size();
+      for (auto i = 0U; i != kInlineEntries; ++i) {
+        auto const match = i < n && ks[i] <= k && transports[i] <= transport;
+        min_segment = match ? std::min(min_segment, segments[i]) : min_segment;
+      }
+      return min_segment;
+    }
+
+    for (auto const& re : s) {
       if (re.k_ <= k && re.transport_ <= transport &&
           re.segment_offset_ < min_segment) {
         min_segment = re.segment_offset_;
@@ -108,7 +128,7 @@ struct reached {
 
   timetable const& tt_;
   tb_data const& tbd_;
-  vector_map<route_idx_t, pareto_set<entry>> data_;
+  vector_map<route_idx_t, set_t> data_;
 };
 
 }  // namespace nigiri::routing::tb
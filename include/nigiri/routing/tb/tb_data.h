@@ -2,6 +2,7 @@
 
 #include <iosfwd>
 
+#include "nigiri/compressed_bitfields.h"
 #include "nigiri/types.h"
 
 #include "utl/verify.h"
@@ -66,7 +67,7 @@ struct tb_data {
   vector_map<transport_idx_t, segment_idx_t> transport_first_segment_;
   vecvec<segment_idx_t, transfer> segment_transfers_;
   vector_map<segment_idx_t, transport_idx_t> segment_transports_;
-  vector_map<tb_bitfield_idx_t, bitfield> bitfields_;
+  compressed_bitfields<tb_bitfield_idx_t> bitfields_;
 };
 
 }  // namespace nigiri::routing::tb
\ No newline at end of file
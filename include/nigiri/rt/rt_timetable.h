@@ -5,11 +5,13 @@
 #include <optional>
 #include <string_view>
 #include <variant>
+#include <vector>
 
 #include "utl/visit.h"
 
 #include "nigiri/common/delta_t.h"
 #include "nigiri/common/interval.h"
+#include "nigiri/compressed_bitfields.h"
 #include "nigiri/rt/run.h"
 #include "nigiri/rt/service_alert.h"
 #include "nigiri/stop.h"
@@ -31,11 +33,15 @@ using change_callback_t =
 // - The real-time timetable does not use bitfields. It requires an initial copy
 //   of the bitfields from the static timetable to be able to deactivate bits
 //   for transports that are updated with delays, rerouting (incl. track
-//   changes) or cancellations (without changing the static timetable).
+//   changes) or cancellations (without changing the static timetable). This
+//   copy is dictionary coded (see compressed_bitfields).
 // - RT transports represent departure and arrival times relative to a base day.
-// - RT transports are currently not grouped into routes to simplify the code.
-//   If this leads to performance issues during the routing, grouping into
-//   routes can be introduced for real-time routing as well.
+// - RT transports with the same stop sequence, vehicle classes and bike/car
+//   carriage are grouped into RT routes. Transports of an RT route do not
+//   overtake each other (FIFO), so routing only needs to scan the earliest
+//   boardable transport of a route. Routes are maintained incrementally: a
+//   transport that is changed such that it no longer fits its route moves to
+//   another (possibly new) RT route.
 // - All RT transports can be resolved via their static transport if they were
 //   already scheduled in the static timetable.
 // - All RT transports that did not exist in the static timetable, can be looked
@@ -68,8 +74,19 @@ struct rt_timetable {
                               rt_transport_stop_times_[rt_t].size());
     rt_transport_stop_times_[rt_t][static_cast<std::size_t>(ev_idx)] =
         unix_to_delta(new_time);
+    if (!is_rt_route_order_valid(rt_t, static_cast<std::size_t>(ev_idx))) {
+      update_rt_route(rt_t);
+    }
   }
 
+  // Moves the RT transport to a matching RT route if its stop sequence or
+  // event times were changed without update_time and it does not fit its
+  // current RT route anymore.
+  void update_rt_route(rt_transport_idx_t);
+
+  // Checks the event against the neighbours in the RT route.
+  bool is_rt_route_order_valid(rt_transport_idx_t, std::size_t ev_idx) const;
+
   void update_lbs(timetable const& tt,
                   rt_transport_idx_t,
                   stop_idx_t,
@@ -182,6 +199,10 @@ struct rt_timetable {
     return rt_transport_src_.size();
   }
 
+  std::uint32_t n_rt_routes() const noexcept {
+    return rt_route_location_seq_.size();
+  }
+
   bool has_car_transport(rt_transport_idx_t const r) const {
     return rt_transport_cars_allowed_[to_idx(r) * 2U] ||
            rt_transport_cars_allowed_[to_idx(r) * 2U + 1U];
@@ -201,12 +222,27 @@ struct rt_timetable {
   // Initial: 100% copy from static, then adapted according to real-time
   // updates
   vector_map<transport_idx_t, bitfield_idx_t> transport_traffic_days_;
-  vector_map<bitfield_idx_t, bitfield> bitfields_;
+  compressed_bitfields<bitfield_idx_t> bitfields_;
 
   // Location -> RT transports that stop at this location
   mutable_fws_multimap<location_idx_t, rt_transport_idx_t>
       location_rt_transports_;
 
+  // Location -> RT routes that stop at this location
+  mutable_fws_multimap<location_idx_t, rt_route_idx_t> location_rt_routes_;
+
+  // RT route -> stop sequence
+  vecvec<rt_route_idx_t, stop::value_type> rt_route_location_seq_;
+
+  // RT route -> transports, sorted by departure at the first stop
+  mutable_fws_multimap<rt_route_idx_t, rt_transport_idx_t> rt_route_transports_;
+
+  // RT transport -> RT route
+  vector_map<rt_transport_idx_t, rt_route_idx_t> rt_transport_route_;
+
+  // Hash of the grouping attributes -> RT routes
+  hash_map<cista::hash_t, vector<rt_route_idx_t>> rt_routes_by_key_;
+
   // Base-day: all real-time timestamps (departures + arrivals in
   // rt_transport_stop_times_) are given relative to this base day.
   date::sys_days base_day_;
@@ -1,11 +1,21 @@
 #pragma once
 
+#include "nigiri/common/parallel_for.h"
 #include "nigiri/rt/run.h"
 #include "nigiri/rt/service_alert.h"
 #include "nigiri/types.h"
 
+#include <chrono>
+#include <filesystem>
+#include <map>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+
+namespace boost::json {
+class object;
+}  // namespace boost::json
 
 namespace pugi {
 class xml_document;
@@ -23,6 +33,9 @@ struct statistics {
   friend std::ostream& operator<<(std::ostream&, statistics const&);
   statistics& operator+=(statistics const&);
 
+  // Counters as used for trace attributes.
+  std::map<std::string, std::uint64_t> to_map() const;
+
   std::uint32_t unsupported_additional_runs_{0U};
   std::uint32_t unsupported_additional_stops_{0U};
 
@@ -52,6 +65,22 @@ struct statistics {
   std::uint32_t updated_events_{0U};
   std::uint32_t propagated_delays_{0U};
 
+  // Runs answered from the match cache without calling match_run.
+  std::uint32_t match_cache_hits_{0U};
+  // Matches loaded from a snapshot and first cache hits on them.
+  std::uint32_t restored_matches_{0U};
+  std::uint32_t restored_match_hits_{0U};
+
+  // Time to parse the payload (only measured when the updater parses it).
+  std::chrono::microseconds parse_time_{0};
+  // Time spent in match_run (summed over threads).
+  std::chrono::microseconds match_time_{0};
+
+  // Share of runs answered from the match cache.
+  double match_cache_hit_rate() const;
+  // Matching time avoided by restored matches (average match time per hit).
+  std::chrono::microseconds restored_time_saved() const;
+
   bool error_{false};
 };
 
@@ -67,8 +96,28 @@ struct updater {
   source_idx_t get_src() const;
   xml_format get_format() const;
 
+  static constexpr auto const kMaxSnapshotMatches = std::size_t{500'000U};
+
+  // Writes the run match cache to warm-start another updater (e.g. after a
+  // restart). Only the `max_entries` most recently used matches within the
+  // retention period are written.
+  void write_matches(std::filesystem::path const&,
+                     std::size_t max_entries = kMaxSnapshotMatches) const;
+
+  // Restores matches written by write_matches. Missing files and snapshots of
+  // a different timetable or source are ignored. Returns the number of
+  // restored matches.
+  std::size_t read_matches(std::filesystem::path const&);
+
+  // Matches runs of one update on the given executor (e.g. a thread pool
+  // owned by the caller). Default: sequentially on the updating thread.
+  void set_parallel_for(parallel_for_fn);
+
   statistics update(rt_timetable&, pugi::xml_document const&);
 
+  // Native SIRI-JSON path (no conversion to XML).
+  statistics update(rt_timetable&, std::string_view siri_json);
+
 private:
   struct vdv_stop {
     explicit vdv_stop(location_idx_t,
@@ -76,6 +125,10 @@ private:
                       pugi::xml_node,
                       xml_format);
 
+    explicit vdv_stop(location_idx_t,
+                      std::string_view id,
+                      boost::json::object const&);
+
     std::optional<std::pair<unixtime_t, event_type>> get_event(
         std::optional<event_type> et = std::nullopt) const;
 
@@ -92,13 +145,35 @@ private:
     std::optional<std::string_view> date_{};
   };
 
+  struct parsed_run {
+    run_id id_;
+    vector<vdv_stop> stops_;
+    bool is_complete_{false};
+    bool is_cancelled_{false};
+  };
+
+  struct match_result {
+    std::vector<run> runs_;
+    statistics stats_;
+  };
+
+  struct route_stop {
+    route_idx_t r_;
+    stop_idx_t stop_idx_;
+  };
+
   std::optional<run_id> resolve_run_id(pugi::xml_node vdv_run);
+  std::optional<run_id> resolve_run_id(boost::json::object const& vdv_run);
+  location_idx_t resolve_stop(std::string_view vdv_stop_id,
+                              bool is_additional_stop,
+                              statistics&) const;
   vector<vdv_stop> resolve_stops(pugi::xml_node vdv_run, statistics&);
+  vector<vdv_stop> resolve_stops(boost::json::object const& vdv_run,
+                                 statistics&);
 
-  void match_run(run_id const&,
-                 vector<vdv_stop> const&,
-                 statistics&,
-                 bool is_complete_run);
+  match_result match_run(run_id const&,
+                         vector<vdv_stop> const&,
+                         bool is_complete_run) const;
 
   void update_run(rt_timetable&,
                   run const&,
@@ -107,27 +182,47 @@ private:
                   statistics&);
 
   void affects_alerts(rt_timetable&, pugi::xml_node affects, alert_idx_t);
-  void process_vdv_run(rt_timetable&, pugi::xml_node vdv_run, statistics&);
+  std::optional<parsed_run> parse_run(pugi::xml_node vdv_run, statistics&);
+  std::optional<parsed_run> parse_run(boost::json::object const& vdv_run,
+                                      statistics&);
+  void process_runs(rt_timetable&,
+                    std::vector<parsed_run> const&,
+                    statistics&);
+  void process_run(rt_timetable&,
+                   parsed_run const&,
+                   match_result* precomputed,
+                   statistics&);
   void process_vdv_alert(rt_timetable&, pugi::xml_node vdv_alert);
 
   void clean_up();
+  void update_cumulative_stats(statistics const&);
+  std::uint64_t get_tt_fingerprint() const;
 
   struct match {
     std::chrono::sys_seconds last_accessed_{
         std::chrono::time_point_cast<std::chrono::seconds>(
             std::chrono::system_clock::now())};
     bool only_saw_incomplete_{false};
+    bool restored_{false};
     std::vector<run> runs_{};
   };
 
   timetable const& tt_;
   source_idx_t src_idx_;
+
+  // location -> (route, stop index) for every stop of a route at the location
+  vecvec<location_idx_t, route_stop> location_route_stops_;
+
   statistics cumulative_stats_{};
   hash_map<std::string, match> matches_{};
   std::chrono::sys_seconds last_cleanup{
       std::chrono::time_point_cast<std::chrono::seconds>(
           std::chrono::system_clock::now())};
   xml_format format_;
+  parallel_for_fn parallel_for_;
+
+  // Identifies the timetable in match snapshots, computed on first use.
+  mutable std::optional<std::uint64_t> tt_fingerprint_;
 };
 
 }  // namespace nigiri::rt::vdv_aus
\ No newline at end of file
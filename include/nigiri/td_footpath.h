@@ -1,11 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <span>
 
 #include "cista/reflection/comparable.h"
 
 #include "utl/cflow.h"
-#include "utl/equal_ranges_linear.h"
 #include "utl/pairwise.h"
 
 #include "nigiri/constants.h"
@@ -28,8 +29,17 @@ std::optional<std::pair<duration_t, typename Collection::value_type>>
 get_td_duration(Collection const& c, unixtime_t const t) {
   using namespace std::chrono_literals;
 
+  // Windows are sorted by valid_from_. Binary search for the first window
+  // that can be relevant instead of scanning all windows before t.
   if constexpr (SearchDir == direction::kForward) {
-    for (auto i = cbegin(c); i != cend(c); ++i) {
+    auto const first_at_or_after_t =
+        std::partition_point(cbegin(c), cend(c), [&](auto const& x) {
+          return x.valid_from_ < t;
+        });
+    auto const start = first_at_or_after_t == cbegin(c)
+                           ? first_at_or_after_t
+                           : std::prev(first_at_or_after_t);
+    for (auto i = start; i != cend(c); ++i) {
       if (i->duration_ == footpath::kMaxDuration ||
           (i->valid_from_ < t && (i + 1) != cend(c) &&
            (i + 1)->valid_from_ <= t)) {
@@ -44,7 +54,12 @@ get_td_duration(Collection const& c, unixtime_t const t) {
     }
 
   } else /* (SearchDir == direction::kBackward) */ {
-    for (auto i = crbegin(c); i != crend(c); ++i) {
+    auto const after_t =
+        std::partition_point(cbegin(c), cend(c), [&](auto const& x) {
+          return x.valid_from_ <= t;
+        });
+    for (auto i = std::next(crbegin(c), std::distance(after_t, cend(c)));
+         i != crend(c); ++i) {
       if (i->duration_ == footpath::kMaxDuration ||
           i->valid_from_ + i->duration_ > t) {
         continue;
@@ -77,19 +92,33 @@ get_td_duration(direction const search_dir,
              : get_td_duration<direction::kBackward>(c, t);
 }
 
+// Footpaths to the same target are stored contiguously. Returns the end of the
+// group starting at `from` (galloping search, logarithmic in the group size).
+template <typename It>
+It get_target_end(It const from, It const end) {
+  auto const same_target = [&](td_footpath const& x) {
+    return x.target_ == from->target_;
+  };
+  auto lo = std::next(from);
+  auto n = std::iter_difference_t<It>{1};
+  while (std::distance(lo, end) > n && same_target(*std::next(lo, n - 1))) {
+    lo = std::next(lo, n);
+    n *= 2;
+  }
+  return std::partition_point(
+      lo, std::next(lo, std::min(n, std::distance(lo, end))), same_target);
+}
+
 template <direction SearchDir, typename Collection, typename Fn>
 void for_each_footpath(Collection const& c, unixtime_t const t, Fn&& f) {
-  utl::equal_ranges_linear(
-      begin(c), end(c),
-      [](td_footpath const& a, td_footpath const& b) {
-        return a.target_ == b.target_;
-      },
-      [&](auto&& from, auto&& to) {
-        auto const fp = get_td_duration<SearchDir>(std::span{from, to}, t);
-        if (fp.has_value()) {
-          f(footpath{from->target_, fp->first});
-        }
-      });
+  for (auto from = begin(c); from != end(c);) {
+    auto const to = get_target_end(from, end(c));
+    auto const fp = get_td_duration<SearchDir>(std::span{from, to}, t);
+    if (fp.has_value()) {
+      f(footpath{from->target_, fp->first});
+    }
+    from = to;
+  }
 }
 
 template <typename Collection, typename Fn>
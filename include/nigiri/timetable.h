@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <compare>
 #include <filesystem>
+#include <limits>
 #include <optional>
 #include <span>
+#include <vector>
 
 #include "cista/memory_holder.h"
 
@@ -13,6 +16,7 @@
 #include "nigiri/common/interval.h"
 #include "nigiri/fares.h"
 #include "nigiri/footpath.h"
+#include "nigiri/route_event_times.h"
 #include "nigiri/stop.h"
 #include "nigiri/string_store.h"
 #include "nigiri/td_footpath.h"
@@ -140,28 +144,109 @@ struct timetable {
 
   transport_idx_t next_transport_idx() const;
 
-  std::span<delta const> event_times_at_stop(route_idx_t const r,
-                                             stop_idx_t const stop_idx,
-                                             event_type const ev_type) const {
+  route_event_times event_times_at_stop(route_idx_t const r,
+                                        stop_idx_t const stop_idx,
+                                        event_type const ev_type) const {
     auto const n_transports =
         static_cast<unsigned>(route_transport_ranges_[r].size());
+    auto const windows = route_headways_[r];
+    auto const n_columns = windows.empty() ? n_transports : 1U;
     auto const idx = static_cast<unsigned>(
         route_stop_time_ranges_[r].from_ +
-        n_transports * (stop_idx * 2 - (ev_type == event_type::kArr ? 1 : 0)));
-    return std::span<delta const>{&route_stop_times_[idx], n_transports};
+        n_columns * (stop_idx * 2 - (ev_type == event_type::kArr ? 1 : 0)));
+    return route_event_times{
+        .times_ = &route_stop_times_[idx],
+        .n_ = n_transports,
+        .windows_ = {windows.begin(), windows.end()}};
   }
 
   delta event_mam(route_idx_t const r,
                   transport_idx_t t,
                   stop_idx_t const stop_idx,
                   event_type const ev_type) const {
-    auto const range = route_transport_ranges_[r];
-    auto const n_transports = static_cast<unsigned>(range.size());
-    auto const route_stop_begin = static_cast<unsigned>(
-        route_stop_time_ranges_[r].from_ +
-        n_transports * (stop_idx * 2 - (ev_type == event_type::kArr ? 1 : 0)));
-    auto const t_idx_in_route = to_idx(t) - to_idx(range.from_);
-    return route_stop_times_[route_stop_begin + t_idx_in_route];
+    auto const t_idx_in_route =
+        to_idx(t) - to_idx(route_transport_ranges_[r].from_);
+    return event_times_at_stop(r, stop_idx, ev_type)[t_idx_in_route];
+  }
+
+  // Writes the event times of the route that was registered last.
+  // get_time(i, ev) returns event ev of the i-th transport of the route
+  // (departure at stop s: ev=2s, arrival at stop s: ev=2s-1). Routes whose
+  // transports are the earliest transport shifted by regular headways are
+  // stored as template + headway windows (see headway_window).
+  template <typename GetTime>
+  void add_route_stop_times(std::uint32_t const n_transports,
+                            std::uint32_t const n_events,
+                            GetTime&& get_time) {
+    // Below this average number of transports per window, the template does
+    // not save enough space to make up for the computed boarding search.
+    constexpr auto const kMinTransportsPerWindow = 4U;
+
+    auto const abs = [&](std::uint32_t const i, std::uint32_t const ev) {
+      auto const d = get_time(i, ev);
+      return d.days() * 1440 + d.mam();
+    };
+
+    auto tmpl = 0U;
+    for (auto i = 1U; i < n_transports; ++i) {
+      if (abs(i, 0U) < abs(tmpl, 0U)) {
+        tmpl = i;
+      }
+    }
+
+    auto windows = std::vector<headway_window>{};
+    auto is_headway_route = n_transports != 0U && n_events != 0U;
+    auto room = 0;  // minutes until the current window wraps around midnight
+    for (auto i = 0U; is_headway_route && i != n_transports; ++i) {
+      auto const offset = abs(i, 0U) - abs(tmpl, 0U);
+      for (auto ev = 0U; is_headway_route && ev != n_events; ++ev) {
+        is_headway_route = abs(i, ev) - abs(tmpl, ev) == offset;
+      }
+      if (!is_headway_route ||
+          offset > std::numeric_limits<std::uint16_t>::max()) {
+        is_headway_route = false;
+        break;
+      }
+
+      if (!windows.empty()) {
+        auto& w = windows.back();
+        auto const j = static_cast<int>(i - w.first_);
+        auto const headway = j == 1 ? offset - w.start_ : w.headway_;
+        if (headway > 0 && headway < 1440 && offset == w.start_ + j * headway &&
+            j * headway < room) {
+          w.headway_ = static_cast<std::uint16_t>(headway);
+          continue;
+        }
+      }
+
+      windows.push_back({.first_ = i,
+                         .start_ = static_cast<std::uint16_t>(offset),
+                         .headway_ = 0U});
+      room = 1440;
+      for (auto ev = 0U; ev != n_events; ++ev) {
+        room = std::min(room, 1440 - (abs(tmpl, ev) + offset) % 1440);
+      }
+    }
+    if (windows.size() * kMinTransportsPerWindow > n_transports) {
+      is_headway_route = false;
+    }
+
+    auto const begin = static_cast<std::uint32_t>(route_stop_times_.size());
+    if (is_headway_route) {
+      for (auto ev = 0U; ev != n_events; ++ev) {
+        route_stop_times_.emplace_back(get_time(tmpl, ev));
+      }
+    } else {
+      windows.clear();
+      for (auto ev = 0U; ev != n_events; ++ev) {
+        for (auto i = 0U; i != n_transports; ++i) {
+          route_stop_times_.emplace_back(get_time(i, ev));
+        }
+      }
+    }
+    route_stop_time_ranges_.emplace_back(interval{
+        begin, static_cast<std::uint32_t>(route_stop_times_.size())});
+    route_headways_.emplace_back(windows);
   }
 
   delta event_mam(transport_idx_t t,
@@ -361,6 +446,14 @@ struct timetable {
   // Location -> list of routes
   vecvec<location_idx_t, route_idx_t> location_routes_;
 
+  // Location -> departures / arrivals of transports per service day in each
+  // hour of the day (UTC), in 1/16 transports (saturating). Used to size
+  // routing search intervals.
+  vector_map<location_idx_t, std::array<std::uint16_t, 24U>>
+      location_hourly_departures_;
+  vector_map<location_idx_t, std::array<std::uint16_t, 24U>>
+      location_hourly_arrivals_;
+
   // Route 1:
   //   stop-1-dep: [trip1, trip2, ..., tripN]
   //   stop-2-arr: [trip1, trip2, ..., tripN]
@@ -372,6 +465,11 @@ struct timetable {
   vector_map<route_idx_t, interval<std::uint32_t>> route_stop_time_ranges_;
   vector<delta> route_stop_times_;
 
+  // Headway routes store only the times of their template transport in
+  // route_stop_times_ (as if the route had a single transport), see
+  // add_route_stop_times. Empty for regular routes.
+  vecvec<route_idx_t, headway_window> route_headways_;
+
   // Offset between the stored time and the time given in the GTFS timetable.
   // Required to match GTFS-RT with GTFS-static trips.
   vector_map<transport_idx_t, delta> transport_first_dep_offset_;
@@ -435,6 +533,9 @@ struct timetable {
   vecvec<flex_area_idx_t, location_idx_t> flex_area_locations_;
   nvec<flex_area_idx_t, geo::latlng, 2U> flex_area_outers_;
   nvec<flex_area_idx_t, geo::latlng, 3U> flex_area_inners_;
+  // Flex area -> grid cells (side x side, row-major by latitude) over the
+  // bounding box: 0 = outside, 1 = inside, 2 = boundary (see flex.h).
+  vecvec<flex_area_idx_t, std::uint8_t> flex_area_cells_;
   vector_map<flex_area_idx_t, translation_idx_t> flex_area_name_;
   vector_map<flex_area_idx_t, translation_idx_t> flex_area_desc_;
   rtree<flex_area_idx_t> flex_area_rtree_;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
@@ -6,6 +7,7 @@
 
 #include "date/date.h"
 
+#include "utl/enumerate.h"
 #include "utl/helpers/algorithm.h"
 #include "utl/overloaded.h"
 #include "utl/progress_tracker.h"
@@ -35,9 +37,20 @@
 
 using namespace date;
 
+// (transport + day, stop + event type + stop change flag)
+using event_change_key_t = nigiri::pair<std::uint64_t, std::uint32_t>;
+
 struct nigiri_timetable {
   std::shared_ptr<nigiri::timetable> tt;
   std::shared_ptr<nigiri::rt_timetable> rtt;
+
+  // Reported value for each event of the previous / current update.
+  // Used to only report events that changed since the previous update.
+  // Only the events of the last update are kept.
+  mutable nigiri::hash_map<event_change_key_t, nigiri_event_change_t>
+      last_event_changes;
+  mutable nigiri::hash_map<event_change_key_t, nigiri_event_change_t>
+      event_changes;
 };
 
 nigiri_timetable_t* nigiri_load_from_dir(nigiri::loader::dir const& d,
@@ -219,10 +232,20 @@ nigiri_location_t* nigiri_get_location_with_footpaths(
                                       : t->tt->locations_.footpaths_out_[0][l];
   auto const n_footpaths = footpaths.size();
   location->footpaths = new nigiri_footpath_t[n_footpaths];
+#if defined(NIGIRI_LARGE_LOCATION_SPACE)
+  for (auto const [i, fp] : utl::enumerate(footpaths)) {
+    location->footpaths[i].target_location_idx =
+        static_cast<nigiri::location_idx_t::value_t>(fp.target());
+    location->footpaths[i].duration =
+        static_cast<std::uint32_t>(fp.duration().count());
+  }
+#else
+  static_assert(sizeof(nigiri_footpath_t) == sizeof(nigiri::footpath));
   if (n_footpaths > 0) {
     std::memcpy(location->footpaths, &footpaths.front(),
                 sizeof(nigiri_footpath_t) * n_footpaths);
   }
+#endif
   location->n_footpaths = static_cast<uint32_t>(n_footpaths);
 
   auto const parent = t->tt->locations_.parents_[l];
@@ -243,34 +266,55 @@ void nigiri_destroy_location(nigiri_location_t const* location) {
   delete location;
 }
 
-void nigiri_update_with_rt_from_buf(nigiri_timetable_t const* t,
-                                    std::string_view protobuf,
-                                    void (*callback)(nigiri_event_change_t,
-                                                     void* context),
-                                    void* context) {
+namespace {
+
+nigiri_event_change_t to_event_change(
+    nigiri::transport const transport,
+    nigiri::stop_idx_t const stop_idx,
+    nigiri::event_type const ev_type,
+    std::optional<nigiri::location_idx_t> const location_idx,
+    std::optional<bool> in_out_allowed,
+    std::optional<nigiri::duration_t> const delay) {
+  return {
+      .transport_idx =
+          static_cast<nigiri::transport_idx_t::value_t>(transport.t_idx_),
+      .day_idx = static_cast<nigiri::day_idx_t::value_t>(transport.day_),
+      .stop_idx = stop_idx,
+      .is_departure = ev_type != nigiri::event_type::kArr,
+      .stop_change = !delay.has_value(),
+      .stop_location_idx = static_cast<nigiri::location_idx_t::value_t>(
+          location_idx.value_or(nigiri::location_idx_t::invalid())),
+      .stop_in_out_allowed = in_out_allowed.value_or(true),
+      .delay = delay.value_or(nigiri::duration_t{0}).count()};
+}
+
+bool has_changed(nigiri_timetable_t const* t, nigiri_event_change_t const& c) {
+  auto const key = event_change_key_t{
+      (static_cast<std::uint64_t>(c.transport_idx) << 16U) | c.day_idx,
+      (static_cast<std::uint32_t>(c.stop_idx) << 2U) |
+          (c.is_departure ? 1U : 0U) | (c.stop_change ? 2U : 0U)};
+  auto const is_same = [&](nigiri_event_change_t const& prev) {
+    return prev.stop_location_idx == c.stop_location_idx &&
+           prev.stop_in_out_allowed == c.stop_in_out_allowed &&
+           prev.delay == c.delay;
+  };
+  auto const [it, inserted] = t->event_changes.emplace(key, c);
+  if (!inserted) {
+    // Reported again within the same update.
+    auto const changed = !is_same(it->second);
+    it->second = c;
+    return changed;
+  }
+  auto const prev = t->last_event_changes.find(key);
+  return prev == end(t->last_event_changes) || !is_same(prev->second);
+}
+
+void update_with_rt(nigiri_timetable_t const* t,
+                    std::string_view protobuf,
+                    nigiri::change_callback_t const& rtt_callback) {
   auto const src = nigiri::source_idx_t{0U};
   auto const tag = "";
 
-  auto const rtt_callback =
-      [&](nigiri::transport const transport, nigiri::stop_idx_t const stop_idx,
-          nigiri::event_type const ev_type,
-          std::optional<nigiri::location_idx_t> const location_idx,
-          std::optional<bool> in_out_allowed,
-          std::optional<nigiri::duration_t> const delay) {
-        nigiri_event_change_t const c = {
-            .transport_idx =
-                static_cast<nigiri::transport_idx_t::value_t>(transport.t_idx_),
-            .day_idx = static_cast<nigiri::day_idx_t::value_t>(transport.day_),
-            .stop_idx = stop_idx,
-            .is_departure = ev_type != nigiri::event_type::kArr,
-            .stop_change = !delay.has_value(),
-            .stop_location_idx = static_cast<nigiri::location_idx_t::value_t>(
-                location_idx.value_or(nigiri::location_idx_t::invalid())),
-            .stop_in_out_allowed = in_out_allowed.value_or(true),
-            .delay = delay.value_or(nigiri::duration_t{0}).count()};
-        callback(c, context);
-      };
-
   t->rtt->set_change_callback(rtt_callback);
   try {
     nigiri::rt::gtfsrt_update_buf(*t->tt, *t->rtt, src, tag, protobuf);
@@ -282,6 +326,23 @@ void nigiri_update_with_rt_from_buf(nigiri_timetable_t const* t,
                 "Unknown GTFS-RT update error (tag={})", tag);
   }
   t->rtt->reset_change_callback();
+
+  std::swap(t->last_event_changes, t->event_changes);
+  t->event_changes.clear();
+}
+
+}  // namespace
+
+void nigiri_update_with_rt_from_buf(nigiri_timetable_t const* t,
+                                    std::string_view protobuf,
+                                    void (*callback)(nigiri_event_change_t,
+                                                     void* context),
+                                    void* context) {
+  update_with_rt(t, protobuf, [&](auto&&... args) {
+    auto const c = to_event_change(args...);
+    has_changed(t, c);
+    callback(c, context);
+  });
 }
 
 void nigiri_update_with_rt(nigiri_timetable_t const* t,
@@ -293,6 +354,54 @@ void nigiri_update_with_rt(nigiri_timetable_t const* t,
   return nigiri_update_with_rt_from_buf(t, file.view(), callback, context);
 }
 
+void nigiri_update_with_rt_from_memory(nigiri_timetable_t const* t,
+                                       char const* gtfsrt_pb_buf,
+                                       size_t gtfsrt_pb_buf_len,
+                                       void (*callback)(nigiri_event_change_t,
+                                                        void* context),
+                                       void* context) {
+  update_with_rt(t, {gtfsrt_pb_buf, gtfsrt_pb_buf_len},
+                 [&](auto&&... args) {
+                   auto const c = to_event_change(args...);
+                   if (has_changed(t, c)) {
+                     callback(c, context);
+                   }
+                 });
+}
+
+void nigiri_update_with_rt_from_memory_batched(
+    nigiri_timetable_t const* t,
+    char const* gtfsrt_pb_buf,
+    size_t gtfsrt_pb_buf_len,
+    uint32_t batch_size,
+    void (*callback)(nigiri_event_change_t const* changes,
+                     uint32_t n_changes,
+                     void* context),
+    void* context) {
+  constexpr auto const kMaxReserve = 1024U;
+  auto batch = std::vector<nigiri_event_change_t>{};
+  batch.reserve(batch_size == 0U ? kMaxReserve
+                                 : std::min(batch_size, kMaxReserve));
+
+  auto const flush = [&]() {
+    if (!batch.empty()) {
+      callback(batch.data(), static_cast<uint32_t>(batch.size()), context);
+      batch.clear();
+    }
+  };
+
+  update_with_rt(t, {gtfsrt_pb_buf, gtfsrt_pb_buf_len}, [&](auto&&... args) {
+    auto const c = to_event_change(args...);
+    if (has_changed(t, c)) {
+      batch.emplace_back(c);
+      if (batch_size != 0U && batch.size() >= batch_size) {
+        flush();
+      }
+    }
+  });
+  flush();
+}
+
 nigiri::pareto_set<nigiri::routing::journey> raptor_search(
     nigiri::timetable const& tt,
     nigiri::rt_timetable const* rtt,
@@ -1,7 +1,10 @@
 #include "nigiri/fares.h"
 
+#include <algorithm>
+#include <numeric>
 #include <ranges>
 
+#include "utl/erase_duplicates.h"
 #include "utl/pairwise.h"
 #include "utl/parser/cstr.h"
 #include "utl/to_vec.h"
@@ -226,6 +229,47 @@ vecvec<location_idx_t, area_idx_t>::const_bucket get_areas(
   return l_areas.empty() ? tt.location_areas_.at(parent(tt, l)) : l_areas;
 }
 
+// Per-call caches shared between the journeys priced by one get_fares call.
+struct fare_cache {
+  // (source << 16 | timezone, time) -> matched timeframe group
+  hash_map<pair<std::uint32_t, std::int64_t>, timeframe_group_idx_t>
+      timeframes_;
+  std::vector<std::uint32_t> candidates_;
+  std::vector<area_idx_t> leg_areas_;
+};
+
+void build_leg_rule_index(fares& f) {
+  auto const key = [&](std::uint32_t const i) {
+    auto const& r = f.fare_leg_rules_[i];
+    return std::tuple{r.network_, r.from_area_, r.to_area_, i};
+  };
+
+  f.leg_rules_by_key_.resize(f.fare_leg_rules_.size());
+  std::iota(begin(f.leg_rules_by_key_), end(f.leg_rules_by_key_), 0U);
+  utl::sort(f.leg_rules_by_key_,
+            [&](std::uint32_t const a, std::uint32_t const b) {
+              return key(a) < key(b);
+            });
+
+  f.concrete_networks_.clear();
+  f.concrete_from_areas_.clear();
+  f.concrete_to_areas_.clear();
+  for (auto const& r : f.fare_leg_rules_) {
+    if (r.network_ != network_idx_t::invalid()) {
+      f.concrete_networks_.push_back(r.network_);
+    }
+    if (r.from_area_ != area_idx_t::invalid()) {
+      f.concrete_from_areas_.push_back(r.from_area_);
+    }
+    if (r.to_area_ != area_idx_t::invalid()) {
+      f.concrete_to_areas_.push_back(r.to_area_);
+    }
+  }
+  utl::erase_duplicates(f.concrete_networks_);
+  utl::erase_duplicates(f.concrete_from_areas_);
+  utl::erase_duplicates(f.concrete_to_areas_);
+}
+
 bool join(timetable const& tt,
           routing::journey::leg const& a_l,
           routing::journey::leg const& b_l) {
@@ -323,14 +367,26 @@ joined_legs_t join_legs(timetable const& tt,
 
 timeframe_group_idx_t match_timeframe(timetable const& tt,
                                       fares const& f,
+                                      fare_cache& cache,
+                                      source_idx_t const src,
                                       location_idx_t const l,
                                       transport_idx_t const t,
                                       unixtime_t const time) {
   auto const stop_tz = tt.locations_.location_timezones_.at(l);
-  auto const& tz = tt.timezones_.at(
+  auto const tz_idx =
       stop_tz == timezone_idx_t::invalid()
           ? tt.providers_[tt.transport_section_providers_.at(t).at(0)].tz_
-          : stop_tz);
+          : stop_tz;
+  auto const cache_key =
+      pair{(static_cast<std::uint32_t>(to_idx(src)) << 16U) |
+               static_cast<std::uint32_t>(to_idx(tz_idx)),
+           static_cast<std::int64_t>(time.time_since_epoch().count())};
+  if (auto const it = cache.timeframes_.find(cache_key);
+      it != end(cache.timeframes_)) {
+    return it->second;
+  }
+
+  auto const& tz = tt.timezones_.at(tz_idx);
   auto const base_day = std::chrono::time_point_cast<date::days>(
       to_local_time(tz, tt.internal_interval_days().from_));
   for (auto i = timeframe_group_idx_t{0U}; i != f.timeframes_.size(); ++i) {
@@ -347,16 +403,19 @@ timeframe_group_idx_t match_timeframe(timetable const& tt,
             fmt::streamed(local_time), fmt::streamed(time), fmt::streamed(day),
             day_idx, tt.strings_.get(f.timeframe_id_[i]), tf.service_,
             tt.strings_.get(tf.service_id_));
+        cache.timeframes_.emplace(cache_key, i);
         return i;
       }
     }
   }
+  cache.timeframes_.emplace(cache_key, timeframe_group_idx_t::invalid());
   return timeframe_group_idx_t::invalid();
 }
 
 std::pair<source_idx_t, std::vector<fares::fare_leg_rule>> match_leg_rule(
     timetable const& tt,
     rt_timetable const* rtt,
+    fare_cache& cache,
     effective_fare_leg_t const& joined_legs) {
 #ifdef NIGIRI_FARES_DEBUG
   trace("EFFECTIVE LEG");
@@ -397,69 +456,91 @@ std::pair<source_idx_t, std::vector<fares::fare_leg_rule>> match_leg_rule(
 
   trace("from: {}", fmt::streamed(from));
   auto const from_tf =
-      match_timeframe(tt, f, from.get_location_idx(), from.fr_->t_.t_idx_,
-                      from.time(event_type::kDep));
+      match_timeframe(tt, f, cache, src, from.get_location_idx(),
+                      from.fr_->t_.t_idx_, from.time(event_type::kDep));
 
   trace("  to: {}", fmt::streamed(to));
   auto const to_tf =
-      match_timeframe(tt, f, to.get_location_idx(), to.fr_->t_.t_idx_,
-                      to.time(event_type::kArr));
-
-  namespace sv = std::views;
-  auto concrete_network =
-      f.fare_leg_rules_ |
-      sv::transform([](auto const& r) { return r.network_; }) |
-      sv::filter([](auto const n) { return n != network_idx_t::invalid(); });
-  auto concrete_from =
-      f.fare_leg_rules_ |
-      sv::transform([](auto const& r) { return r.from_area_; }) |
-      sv::filter([](auto const a) { return a != area_idx_t::invalid(); });
-  auto concrete_to =
-      f.fare_leg_rules_ |
-      sv::transform([](auto const& r) { return r.to_area_; }) |
-      sv::filter([](auto const a) { return a != area_idx_t::invalid(); });
+      match_timeframe(tt, f, cache, src, to.get_location_idx(),
+                      to.fr_->t_.t_idx_, to.time(event_type::kArr));
 
-  auto const has_area = [&](area_idx_t const x) {
-    for (auto const& l : joined_legs) {
-      auto const ree = std::get<journey::run_enter_exit>(l->uses_);
-      auto const fr = rt::frun{tt, rtt, ree.r_};
-      auto const a = static_cast<stop_idx_t>(ree.stop_range_.from_);
-      auto const b = static_cast<stop_idx_t>(ree.stop_range_.to_);
-      for (auto i = a; i < b; ++i) {
-        auto const stop_areas = get_areas(tt, fr[i].get_location_idx());
-        if (utl::find(stop_areas, x) != end(stop_areas)) {
-          return true;
-        }
-      }
+  utl::verify(f.leg_rules_by_key_.size() == f.fare_leg_rules_.size(),
+              "fare leg rule index not built");
+
+  auto const is_concrete = [](auto const& sorted, auto const x) {
+    return std::binary_search(begin(sorted), end(sorted), x);
+  };
+  auto const is_concrete_network = [&](network_idx_t const x) {
+    return is_concrete(f.concrete_networks_, x);
+  };
+  auto const is_concrete_from = [&](area_idx_t const x) {
+    return is_concrete(f.concrete_from_areas_, x);
+  };
+  auto const is_concrete_to = [&](area_idx_t const x) {
+    return is_concrete(f.concrete_to_areas_, x);
+  };
+
+  // Areas of all stops visited by the joined legs.
+  auto& leg_areas = cache.leg_areas_;
+  leg_areas.clear();
+  for (auto const& l : joined_legs) {
+    auto const ree = std::get<journey::run_enter_exit>(l->uses_);
+    auto const fr = rt::frun{tt, rtt, ree.r_};
+    auto const a = static_cast<stop_idx_t>(ree.stop_range_.from_);
+    auto const b = static_cast<stop_idx_t>(ree.stop_range_.to_);
+    for (auto i = a; i < b; ++i) {
+      auto const stop_areas = get_areas(tt, fr[i].get_location_idx());
+      trace("areas of {}: {}", fmt::streamed(fr[i].get_loc()),
+            stop_areas | std::views::transform([&](area_idx_t const x) {
+              return tt.strings_.get(tt.areas_[x].name_);
+            }));
+      leg_areas.insert(end(leg_areas), begin(stop_areas), end(stop_areas));
     }
-    return false;
+  }
+  utl::erase_duplicates(leg_areas);
+
+  auto const has_area = [&](area_idx_t const x) {
+    return std::binary_search(begin(leg_areas), end(leg_areas), x);
   };
 
   auto const has_other_area =
       [&](vecvec<area_set_idx_t, area_idx_t>::const_bucket const& exact_areas) {
-        for (auto const& l : joined_legs) {
-          auto const ree = std::get<journey::run_enter_exit>(l->uses_);
-          auto const fr = rt::frun{tt, rtt, ree.r_};
-          auto const a = static_cast<stop_idx_t>(ree.stop_range_.from_);
-          auto const b = static_cast<stop_idx_t>(ree.stop_range_.to_);
-          for (auto i = a; i < b; ++i) {
-            auto const stop_areas = get_areas(tt, fr[i].get_location_idx());
-            trace("areas of {}: {}", fmt::streamed(fr[i].get_loc()),
-                  stop_areas | std::views::transform([&](area_idx_t const x) {
-                    return tt.strings_.get(tt.areas_[x].name_);
-                  }));
-            auto const contains_other_area =
-                utl::any_of(stop_areas, [&](area_idx_t const x) {
-                  return std::ranges::find(exact_areas, x) == end(exact_areas);
-                });
-            if (contains_other_area) {
-              return true;
-            }
-          }
-        }
-        return false;
+        return utl::any_of(leg_areas, [&](area_idx_t const x) {
+          return std::ranges::find(exact_areas, x) == end(exact_areas);
+        });
       };
 
+  // Rules for (network, from_area, to_area): each may be concrete or "any".
+  auto const for_each_candidate = [&](fares::fare_leg_rule const& x,
+                                      auto&& fn) {
+    auto const key = [&](std::uint32_t const i) {
+      auto const& r = f.fare_leg_rules_[i];
+      return std::tuple{r.network_, r.from_area_, r.to_area_};
+    };
+
+    auto& candidates = cache.candidates_;
+    candidates.clear();
+    for (auto const n : {network_idx_t::invalid(), x.network_}) {
+      for (auto const from_area : {area_idx_t::invalid(), x.from_area_}) {
+        for (auto const to_area : {area_idx_t::invalid(), x.to_area_}) {
+          auto const k = std::tuple{n, from_area, to_area};
+          auto const lb = std::partition_point(
+              begin(f.leg_rules_by_key_), end(f.leg_rules_by_key_),
+              [&](std::uint32_t const i) { return key(i) < k; });
+          auto const ub = std::partition_point(
+              lb, end(f.leg_rules_by_key_),
+              [&](std::uint32_t const i) { return key(i) == k; });
+          candidates.insert(end(candidates), lb, ub);
+        }
+      }
+    }
+    utl::erase_duplicates(candidates);
+
+    for (auto const i : candidates) {
+      fn(f.fare_leg_rules_[i]);
+    }
+  };
+
   auto const for_each_area = [&](location_idx_t const l, auto&& fn) {
     auto const areas = get_areas(tt, l);
     if (areas.empty()) {
@@ -479,16 +560,16 @@ std::pair<source_idx_t, std::vector<fares::fare_leg_rule>> match_leg_rule(
                                           .to_area_ = to_area,
                                           .from_timeframe_group_ = from_tf,
                                           .to_timeframe_group_ = to_tf};
-      for (auto const& r : f.fare_leg_rules_) {
+      for_each_candidate(x, [&](fares::fare_leg_rule const& r) {
         auto const matches =
             ((r.network_ == network_idx_t::invalid() &&
-              (f.has_priority_ || !contains(concrete_network, x.network_))) ||
+              (f.has_priority_ || !is_concrete_network(x.network_))) ||
              r.network_ == x.network_) &&
             ((r.from_area_ == area_idx_t::invalid() &&
-              (f.has_priority_ || !contains(concrete_from, x.from_area_))) ||
+              (f.has_priority_ || !is_concrete_from(x.from_area_))) ||
              r.from_area_ == x.from_area_) &&
             ((r.to_area_ == area_idx_t::invalid() &&
-              (f.has_priority_ || !contains(concrete_to, x.to_area_))) ||
+              (f.has_priority_ || !is_concrete_to(x.to_area_))) ||
              r.to_area_ == x.to_area_) &&
             (r.from_timeframe_group_ == timeframe_group_idx_t::invalid() ||
              r.from_timeframe_group_ == x.from_timeframe_group_) &&
@@ -513,15 +594,15 @@ std::pair<source_idx_t, std::vector<fares::fare_leg_rule>> match_leg_rule(
               std::pair<char const*, bool>>{
               {"network",
                (r.network_ == network_idx_t::invalid() &&
-                (f.has_priority_ || !contains(concrete_network, x.network_))) ||
+                (f.has_priority_ || !is_concrete_network(x.network_))) ||
                    r.network_ == x.network_},
               {"from_area",
                (r.from_area_ == area_idx_t::invalid() &&
-                (f.has_priority_ || !contains(concrete_from, x.from_area_))) ||
+                (f.has_priority_ || !is_concrete_from(x.from_area_))) ||
                    r.from_area_ == x.from_area_},
               {"to_area",
                (r.to_area_ == area_idx_t::invalid() &&
-                (f.has_priority_ || !contains(concrete_to, x.to_area_))) ||
+                (f.has_priority_ || !is_concrete_to(x.to_area_))) ||
                    r.to_area_ == x.to_area_},
               {"from_timeframe",
                r.from_timeframe_group_ == timeframe_group_idx_t::invalid() ||
@@ -545,7 +626,7 @@ std::pair<source_idx_t, std::vector<fares::fare_leg_rule>> match_leg_rule(
             }
           }
         }
-      }
+      });
     });
   });
   utl::sort(matching_rules, [&](fares::fare_leg_rule const& a,
@@ -752,14 +833,32 @@ std::vector<fare_transfer> join_transfers(
 
 std::vector<fare_transfer> get_fares(timetable const& tt,
                                      rt_timetable const* rtt,
+                                     fare_cache& cache,
                                      journey const& j) {
   return join_transfers(
       tt, utl::to_vec(join_legs(tt, get_transit_legs(j)),
                       [&](effective_fare_leg_t const& joined_leg) {
                         auto const [src, rules] =
-                            match_leg_rule(tt, rtt, joined_leg);
+                            match_leg_rule(tt, rtt, cache, joined_leg);
                         return fare_leg{src, joined_leg, rules};
                       }));
 }
 
+std::vector<fare_transfer> get_fares(timetable const& tt,
+                                     rt_timetable const* rtt,
+                                     journey const& j) {
+  auto cache = fare_cache{};
+  return get_fares(tt, rtt, cache, j);
+}
+
+std::vector<std::vector<fare_transfer>> get_fares(
+    timetable const& tt,
+    rt_timetable const* rtt,
+    pareto_set<journey> const& journeys) {
+  auto cache = fare_cache{};
+  return utl::to_vec(journeys, [&](journey const& j) {
+    return get_fares(tt, rtt, cache, j);
+  });
+}
+
 }  // namespace nigiri
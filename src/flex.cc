@@ -1,5 +1,9 @@
 #include "nigiri/flex.h"
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
 #include "geo/detail/register_latlng.h"
 
 #include "boost/geometry/algorithms/within.hpp"
@@ -110,11 +114,177 @@ multi_polygon get_area(timetable const& tt, flex_area_idx_t const area) {
   return mp;
 }
 
+namespace {
+
+enum flex_cell : std::uint8_t { kOutside, kInside, kBoundary };
+
+std::uint32_t get_grid_side(std::size_t const n_cells) {
+  return static_cast<std::uint32_t>(
+      std::lround(std::sqrt(static_cast<double>(n_cells))));
+}
+
+std::uint32_t to_cell(double const x,
+                      double const min,
+                      double const max,
+                      std::uint32_t const side) {
+  if (max <= min) {
+    return 0U;
+  }
+  auto const c = static_cast<std::int64_t>((x - min) / (max - min) * side);
+  return static_cast<std::uint32_t>(
+      std::clamp(c, std::int64_t{0}, static_cast<std::int64_t>(side) - 1));
+}
+
+flex_cell get_cell(timetable const& tt,
+                   flex_area_idx_t const a,
+                   geo::latlng const& pos) {
+  auto const& box = tt.flex_area_bbox_[a];
+  auto const cells = tt.flex_area_cells_[a];
+  auto const side = get_grid_side(cells.size());
+  auto const x = to_cell(pos.lng_, box.min_.lng_, box.max_.lng_, side);
+  auto const y = to_cell(pos.lat_, box.min_.lat_, box.max_.lat_, side);
+  return static_cast<flex_cell>(cells[y * side + x]);
+}
+
+}  // namespace
+
+void build_flex_area_index(timetable& tt) {
+  constexpr auto const kMinSide = 4U;
+  constexpr auto const kMaxSide = 64U;
+
+  tt.flex_area_cells_.clear();
+
+  auto cells = std::vector<std::uint8_t>{};
+  for (auto idx = 0U; idx != tt.flex_area_bbox_.size(); ++idx) {
+    auto const a = flex_area_idx_t{idx};
+    auto const& box = tt.flex_area_bbox_[a];
+    auto const area = get_area(tt, a);
+    auto const outers = tt.flex_area_outers_[a];
+    auto const inners = tt.flex_area_inners_[a];
+
+    auto const for_each_ring = [&](auto&& fn) {
+      for (auto i = 0U; i != outers.size(); ++i) {
+        fn(outers[i]);
+        for (auto j = 0U; j != inners[i].size(); ++j) {
+          fn(inners[i][j]);
+        }
+      }
+    };
+
+    auto n_vertices = std::size_t{0U};
+    for_each_ring([&](auto const& ring) { n_vertices += ring.size(); });
+
+    auto const degenerate =
+        box.max_.lng_ <= box.min_.lng_ || box.max_.lat_ <= box.min_.lat_;
+    auto const side =
+        degenerate ? 1U
+                   : std::clamp(2U * static_cast<std::uint32_t>(std::sqrt(
+                                         static_cast<double>(n_vertices))),
+                                kMinSide, kMaxSide);
+    cells.assign(side * side, kOutside);
+
+    if (degenerate) {
+      cells.front() = kBoundary;
+      tt.flex_area_cells_.emplace_back(cells);
+      continue;
+    }
+
+    // Cells touched by an edge (conservative: the cells covering the bounding
+    // box of the edge, extended by one cell) are boundary cells.
+    auto const mark_edge = [&](geo::latlng const& p, geo::latlng const& q) {
+      auto const x0 = to_cell(std::min(p.lng_, q.lng_), box.min_.lng_,
+                              box.max_.lng_, side);
+      auto const x1 = to_cell(std::max(p.lng_, q.lng_), box.min_.lng_,
+                              box.max_.lng_, side);
+      auto const y0 = to_cell(std::min(p.lat_, q.lat_), box.min_.lat_,
+                              box.max_.lat_, side);
+      auto const y1 = to_cell(std::max(p.lat_, q.lat_), box.min_.lat_,
+                              box.max_.lat_, side);
+      for (auto y = y0 == 0U ? 0U : y0 - 1U; y <= std::min(y1 + 1U, side - 1U);
+           ++y) {
+        for (auto x = x0 == 0U ? 0U : x0 - 1U;
+             x <= std::min(x1 + 1U, side - 1U); ++x) {
+          cells[y * side + x] = kBoundary;
+        }
+      }
+    };
+    for_each_ring([&](auto const& ring) {
+      if (ring.size() == 0U) {
+        return;
+      }
+      for (auto i = 1U; i < ring.size(); ++i) {
+        mark_edge(ring[i - 1U], ring[i]);
+      }
+      mark_edge(ring[ring.size() - 1U], ring[0U]);
+    });
+
+    // Remaining cells are entirely inside or outside. Their corners and
+    // center have to agree, otherwise the exact test is kept.
+    auto const cell_w = (box.max_.lng_ - box.min_.lng_) / side;
+    auto const cell_h = (box.max_.lat_ - box.min_.lat_) / side;
+    for (auto y = 0U; y != side; ++y) {
+      for (auto x = 0U; x != side; ++x) {
+        auto& c = cells[y * side + x];
+        if (c == kBoundary) {
+          continue;
+        }
+        auto const at = [&](double const fx, double const fy) {
+          return boost::geometry::within(
+              geo::latlng{box.min_.lat_ + (y + fy) * cell_h,
+                          box.min_.lng_ + (x + fx) * cell_w},
+              area);
+        };
+        auto const center = at(0.5, 0.5);
+        auto const uniform = at(0.0, 0.0) == center &&
+                             at(1.0, 0.0) == center &&
+                             at(0.0, 1.0) == center && at(1.0, 1.0) == center;
+        c = !uniform ? kBoundary : (center ? kInside : kOutside);
+      }
+    }
+
+    tt.flex_area_cells_.emplace_back(cells);
+  }
+}
+
 bool is_in_flex_area(timetable const& tt,
                      flex_area_idx_t const a,
                      geo::latlng const& pos) {
-  return tt.flex_area_bbox_[a].contains(pos) &&
-         boost::geometry::within(pos, get_area(tt, a));
+  if (!tt.flex_area_bbox_[a].contains(pos)) {
+    return false;
+  }
+  if (to_idx(a) < tt.flex_area_cells_.size()) {
+    auto const c = get_cell(tt, a, pos);
+    if (c != kBoundary) {
+      return c == kInside;
+    }
+  }
+  return boost::geometry::within(pos, get_area(tt, a));
 }
 
-}  // namespace nigiri
\ No newline at end of file
+void is_in_flex_area(timetable const& tt,
+                     flex_area_idx_t const a,
+                     std::span<geo::latlng const> positions,
+                     bitvec& result) {
+  result.resize(static_cast<bitvec::size_type>(positions.size()));
+  auto const& box = tt.flex_area_bbox_[a];
+  auto const has_index = to_idx(a) < tt.flex_area_cells_.size();
+  auto area = std::optional<multi_polygon>{};
+  for (auto i = 0U; i != positions.size(); ++i) {
+    auto const& pos = positions[i];
+    auto in = false;
+    if (box.contains(pos)) {
+      auto const c = has_index ? get_cell(tt, a, pos) : kBoundary;
+      if (c == kBoundary) {
+        if (!area.has_value()) {
+          area = get_area(tt, a);
+        }
+        in = boost::geometry::within(pos, *area);
+      } else {
+        in = c == kInside;
+      }
+    }
+    result.set(i, in);
+  }
+}
+
+}  // namespace nigiri
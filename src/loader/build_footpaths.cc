@@ -76,9 +76,9 @@ footgraph get_footpath_graph(timetable& tt) {
     utl::erase_if(g[i],
                   [&](auto&& fp) { return fp.target() == location_idx_t{i}; });
     utl::erase_duplicates(
-        g[i], [](auto&& a, auto&& b) { return a.target_ < b.target_; },
+        g[i], [](auto&& a, auto&& b) { return a.target() < b.target(); },
         [](auto&& a, auto&& b) {
-          return a.target_ == b.target_;
+          return a.target() == b.target();
         });  // also sorts
   }
   return g;
@@ -128,9 +128,10 @@ void process_2_node_component(timetable& tt,
   auto const idx_b = to_idx(l_idx_b);
 
   if (!fgraph[idx_a].empty()) {
-    auto const duration = std::max({u8_minutes{fgraph[idx_a].front().duration_},
-                                    tt.locations_.transfer_time_[l_idx_a],
-                                    tt.locations_.transfer_time_[l_idx_b]});
+    auto const duration =
+        std::max({u8_minutes{fgraph[idx_a].front().duration().count()},
+                  tt.locations_.transfer_time_[l_idx_a],
+                  tt.locations_.transfer_time_[l_idx_b]});
     tt.locations_.preprocessing_footpaths_out_[l_idx_a].emplace_back(l_idx_b,
                                                                      duration);
     tt.locations_.preprocessing_footpaths_in_[l_idx_b].emplace_back(l_idx_a,
@@ -138,9 +139,10 @@ void process_2_node_component(timetable& tt,
   }
 
   if (!fgraph[idx_b].empty()) {
-    auto const duration = std::max({u8_minutes{fgraph[idx_b].front().duration_},
-                                    tt.locations_.transfer_time_[l_idx_a],
-                                    tt.locations_.transfer_time_[l_idx_b]});
+    auto const duration =
+        std::max({u8_minutes{fgraph[idx_b].front().duration().count()},
+                  tt.locations_.transfer_time_[l_idx_a],
+                  tt.locations_.transfer_time_[l_idx_b]});
     tt.locations_.preprocessing_footpaths_out_[l_idx_b].emplace_back(l_idx_a,
                                                                      duration);
     tt.locations_.preprocessing_footpaths_in_[l_idx_a].emplace_back(l_idx_b,
@@ -377,7 +379,7 @@ void add_links_to_and_between_children(timetable& tt) {
 
 void sort_footpaths(timetable& tt) {
   auto const cmp_fp_dur = [](auto const& a, auto const& b) {
-    return a.duration_ < b.duration_;
+    return a.duration() < b.duration();
   };
   for (auto i = location_idx_t{0U}; i != tt.n_locations(); ++i) {
     utl::sort(tt.locations_.preprocessing_footpaths_out_[i], cmp_fp_dur);
@@ -410,6 +412,8 @@ void write_footpaths(timetable& tt) {
 }
 
 void build_footpaths(timetable& tt, finalize_options const opt) {
+  auto const timer = scoped_timer{"loader.footpaths"};
+
   add_links_to_and_between_children(tt);
   link_nearby_stations(tt);
   if (opt.merge_dupes_intra_src_ || opt.merge_dupes_inter_src_) {
@@ -433,6 +437,11 @@ void build_footpaths(timetable& tt, finalize_options const opt) {
   connect_components(tt, opt.max_footpath_length_, opt.adjust_footpaths_);
   sort_footpaths(tt);
   write_footpaths(tt);
+
+  timer.set_attribute("nigiri.tt.n_locations", tt.n_locations());
+  timer.set_attribute(
+      "nigiri.tt.n_footpaths",
+      tt.locations_.footpaths_out_[kDefaultProfile].data_.size());
 }
 
 }  // namespace nigiri::loader
@@ -0,0 +1,176 @@
+#include "nigiri/loader/build_lb_graph.h"
+
+#include <algorithm>
+#include <execution>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "utl/parallel_for.h"
+
+#include "nigiri/logging.h"
+
+namespace nigiri::loader {
+
+route_segment_times_t get_route_segment_min_times(timetable const& tt) {
+  auto const timer = scoped_timer{"nigiri.loader.lb.segment_times"};
+
+  auto is_active = std::vector<std::uint8_t>(tt.transport_traffic_days_.size());
+  for (auto t = transport_idx_t{0U}; t != tt.next_transport_idx(); ++t) {
+    is_active[to_idx(t)] =
+        tt.bitfields_[tt.transport_traffic_days_[t]].none() ? 0U : 1U;
+  }
+
+  auto segment_times = route_segment_times_t{};
+  auto times = std::vector<duration_t>{};
+  for (auto r = route_idx_t{0U}; r != tt.n_routes(); ++r) {
+    auto const transports = tt.route_transport_ranges_[r];
+    auto const n_segments = tt.route_location_seq_[r].size() - 1U;
+    auto const active = std::span{is_active}.subspan(to_idx(transports.from_),
+                                                     transports.size());
+
+    times.clear();
+    for (auto i = 0U; i != n_segments; ++i) {
+      if (transports.empty()) {
+        times.emplace_back(kNoSegmentTime);
+        continue;
+      }
+
+      // Departures at stop i and arrivals at stop i+1 are stored
+      // contiguously for all transports of the route.
+      auto const dep = tt.event_times_at_stop(r, static_cast<stop_idx_t>(i),
+                                              event_type::kDep);
+      auto const arr = tt.event_times_at_stop(
+          r, static_cast<stop_idx_t>(i + 1U), event_type::kArr);
+      constexpr auto const kNone = std::numeric_limits<int>::max();
+      auto min = kNone;
+      for (auto j = 0U; j != dep.size(); ++j) {
+        auto const d = (arr[j].days_ - dep[j].days_) * 1440 +
+                       (arr[j].mam_ - dep[j].mam_);
+        min = active[j] != 0U ? std::min(min, d) : min;
+      }
+      times.emplace_back(
+          min == kNone ? kNoSegmentTime
+                       : duration_t{static_cast<duration_t::rep>(std::min(
+                             min, kNoSegmentTime.count() - 1))});
+    }
+    segment_times.emplace_back(times);
+  }
+
+  return segment_times;
+}
+
+template <direction SearchDir>
+void build_lb_graph(timetable& tt,
+                    profile_idx_t const prf_idx,
+                    route_segment_times_t const& segment_min_times) {
+  struct edge {
+    location_idx_t from_, to_;
+    duration_t duration_;
+  };
+
+  auto const timer = scoped_timer{"nigiri.loader.lb"};
+
+  auto edges = std::vector<edge>{};
+  auto const add_edge = [&](location_idx_t const l, location_idx_t const target,
+                            duration_t const d) {
+    auto const from = tt.locations_.get_root_idx(l);
+    auto const to = tt.locations_.get_root_idx(target);
+    if (from != to) {
+      edges.push_back({from, to, d});
+    }
+  };
+
+  auto const& footpaths = SearchDir == direction::kForward
+                              ? tt.locations_.footpaths_in_[prf_idx]
+                              : tt.locations_.footpaths_out_[prf_idx];
+  for (auto i = 0U; i != footpaths.size(); ++i) {
+    auto const l = location_idx_t{i};
+    for (auto const& fp : footpaths[l]) {
+      add_edge(l, fp.target(), fp.duration());
+    }
+  }
+
+  for (auto r = route_idx_t{0U}; r != tt.n_routes(); ++r) {
+    if ((prf_idx == kCarProfile && !tt.has_car_transport(r)) ||
+        (prf_idx == kBikeProfile && !tt.has_bike_transport(r))) {
+      continue;
+    }
+
+    auto const location_seq = tt.route_location_seq_[r];
+    auto const times = segment_min_times[r];
+    for (auto i = 0U; i != times.size(); ++i) {
+      if (times[i] == kNoSegmentTime) {
+        continue;
+      }
+      auto const from_l = stop{location_seq[i]}.location_idx();
+      auto const to_l = stop{location_seq[i + 1U]}.location_idx();
+      if constexpr (SearchDir == direction::kForward) {
+        add_edge(to_l, from_l, times[i]);
+      } else {
+        add_edge(from_l, to_l, times[i]);
+      }
+    }
+  }
+
+  // Shortest edge first for each (from, to) pair.
+  std::sort(
+#if __cpp_lib_execution
+      std::execution::par_unseq,
+#endif
+      begin(edges), end(edges), [](edge const& a, edge const& b) {
+        return std::tie(a.from_, a.to_, a.duration_) <
+               std::tie(b.from_, b.to_, b.duration_);
+      });
+
+  auto& lb_graph = SearchDir == direction::kForward
+                       ? tt.fwd_search_lb_graph_[prf_idx]
+                       : tt.bwd_search_lb_graph_[prf_idx];
+  lb_graph.clear();
+
+  auto it = begin(edges);
+  auto out = std::vector<footpath>{};
+  for (auto l = location_idx_t{0U}; l != tt.n_locations(); ++l) {
+    out.clear();
+    for (; it != end(edges) && it->from_ == l; ++it) {
+      if (out.empty() || out.back().target() != it->to_) {
+        out.emplace_back(footpath{it->to_, it->duration_});
+      }
+    }
+    lb_graph.emplace_back(out);
+  }
+
+  timer.set_attribute("nigiri.lb.profile", prf_idx);
+  timer.set_attribute("nigiri.lb.n_edges", lb_graph.data_.size());
+}
+
+template void build_lb_graph<direction::kForward>(
+    timetable&, profile_idx_t, route_segment_times_t const&);
+template void build_lb_graph<direction::kBackward>(
+    timetable&, profile_idx_t, route_segment_times_t const&);
+
+void build_lb_graphs(timetable& tt) {
+  auto const segment_min_times = get_route_segment_min_times(tt);
+
+  auto graphs = std::vector<std::pair<profile_idx_t, direction>>{};
+  for (auto p = 0U; p != kNProfiles; ++p) {
+    auto const prf_idx = static_cast<profile_idx_t>(p);
+    if (prf_idx == kDefaultProfile ||
+        !tt.locations_.footpaths_out_[prf_idx].empty()) {
+      graphs.emplace_back(prf_idx, direction::kForward);
+      graphs.emplace_back(prf_idx, direction::kBackward);
+    }
+  }
+
+  utl::parallel_for_run(graphs.size(), [&](std::size_t const i) {
+    auto const [prf_idx, dir] = graphs[i];
+    if (dir == direction::kForward) {
+      build_lb_graph<direction::kForward>(tt, prf_idx, segment_min_times);
+    } else {
+      build_lb_graph<direction::kBackward>(tt, prf_idx, segment_min_times);
+    }
+  });
+}
+
+}  // namespace nigiri::loader
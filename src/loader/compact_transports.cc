@@ -0,0 +1,252 @@
+#include "nigiri/loader/compact_transports.h"
+
+#include <vector>
+
+#include "utl/enumerate.h"
+#include "utl/helpers/algorithm.h"
+
+#include "nigiri/logging.h"
+#include "nigiri/shapes_storage.h"
+#include "nigiri/timetable.h"
+
+namespace nigiri::loader {
+
+namespace {
+
+void compact_transport_data(
+    timetable& tt,
+    vector_map<transport_idx_t, transport_idx_t> const& transport_map,
+    vector_map<route_idx_t, route_idx_t> const& route_map) {
+  auto const has_day_offsets =
+      tt.initial_day_offset_.size() == tt.transport_traffic_days_.size();
+
+  auto first_dep_offset = vector_map<transport_idx_t, delta>{};
+  auto day_offset = vector_map<transport_idx_t, std::uint8_t>{};
+  auto traffic_days = vector_map<transport_idx_t, bitfield_idx_t>{};
+  auto route = vector_map<transport_idx_t, route_idx_t>{};
+  auto trip_sections = vecvec<transport_idx_t, merged_trips_idx_t>{};
+  auto attributes = vecvec<transport_idx_t, attribute_combination_idx_t>{};
+  auto providers = vecvec<transport_idx_t, provider_idx_t>{};
+  auto directions = vecvec<transport_idx_t, translation_idx_t>{};
+  for (auto t = transport_idx_t{0U}; t != tt.next_transport_idx(); ++t) {
+    if (transport_map[t] == transport_idx_t::invalid()) {
+      continue;
+    }
+    first_dep_offset.emplace_back(tt.transport_first_dep_offset_[t]);
+    if (has_day_offsets) {
+      day_offset.emplace_back(tt.initial_day_offset_[t]);
+    }
+    traffic_days.emplace_back(tt.transport_traffic_days_[t]);
+    route.emplace_back(route_map[tt.transport_route_[t]]);
+    trip_sections.emplace_back(tt.transport_to_trip_section_[t]);
+    attributes.emplace_back(tt.transport_section_attributes_[t]);
+    providers.emplace_back(tt.transport_section_providers_[t]);
+    directions.emplace_back(tt.transport_section_directions_[t]);
+  }
+
+  tt.transport_first_dep_offset_ = std::move(first_dep_offset);
+  if (has_day_offsets) {
+    tt.initial_day_offset_ = std::move(day_offset);
+  }
+  tt.transport_traffic_days_ = std::move(traffic_days);
+  tt.transport_route_ = std::move(route);
+  tt.transport_to_trip_section_ = std::move(trip_sections);
+  tt.transport_section_attributes_ = std::move(attributes);
+  tt.transport_section_providers_ = std::move(providers);
+  tt.transport_section_directions_ = std::move(directions);
+}
+
+void compact_route_data(
+    timetable& tt,
+    vector_map<transport_idx_t, transport_idx_t> const& transport_map,
+    vector_map<route_idx_t, route_idx_t> const& route_map,
+    unsigned const n_routes) {
+  auto transport_ranges = vector_map<route_idx_t, interval<transport_idx_t>>{};
+  auto times = timetable{};  // only holds the event times of kept routes
+  auto kept = std::vector<std::uint32_t>{};
+  auto location_seq = vecvec<route_idx_t, stop::value_type>{};
+  auto route_clasz = vector_map<route_idx_t, clasz>{};
+  auto section_clasz = vecvec<route_idx_t, clasz>{};
+  auto bikes_allowed = bitvec{};
+  auto cars_allowed = bitvec{};
+  auto bikes_allowed_per_section = vecvec<route_idx_t, bool>{};
+  auto cars_allowed_per_section = vecvec<route_idx_t, bool>{};
+  bikes_allowed.resize(n_routes * 2U);
+  cars_allowed.resize(n_routes * 2U);
+
+  for (auto r = route_idx_t{0U}; r != tt.n_routes(); ++r) {
+    auto const new_r = route_map[r];
+    if (new_r == route_idx_t::invalid()) {
+      continue;
+    }
+
+    // Kept transports are numbered consecutively in their original order,
+    // so the transports of a route stay a contiguous range.
+    auto const old_transports = tt.route_transport_ranges_[r];
+    auto from = transport_idx_t::invalid();
+    auto to = transport_idx_t::invalid();
+    for (auto const t : old_transports) {
+      if (transport_map[t] != transport_idx_t::invalid()) {
+        if (from == transport_idx_t::invalid()) {
+          from = transport_map[t];
+        }
+        to = transport_idx_t{to_idx(transport_map[t]) + 1U};
+      }
+    }
+    transport_ranges.emplace_back(interval<transport_idx_t>{from, to});
+
+    // Event times are written anew: dropping transports can change the
+    // headway windows of a route (see add_route_stop_times).
+    kept.clear();
+    for (auto const [i, t] : utl::enumerate(old_transports)) {
+      if (transport_map[t] != transport_idx_t::invalid()) {
+        kept.push_back(static_cast<std::uint32_t>(i));
+      }
+    }
+    auto const n_stops = tt.route_location_seq_[r].size();
+    times.add_route_stop_times(
+        static_cast<std::uint32_t>(kept.size()),
+        static_cast<std::uint32_t>((n_stops - 1U) * 2U),
+        [&](std::uint32_t const i, std::uint32_t const ev) {
+          // Departure at stop s: ev=2s, arrival at stop s: ev=2s-1.
+          auto const is_arr = ev % 2U == 1U;
+          return tt.event_times_at_stop(
+              r, static_cast<stop_idx_t>((ev + 1U) / 2U),
+              is_arr ? event_type::kArr : event_type::kDep)[kept[i]];
+        });
+
+    location_seq.emplace_back(tt.route_location_seq_[r]);
+    route_clasz.emplace_back(tt.route_clasz_[r]);
+    section_clasz.emplace_back(tt.route_section_clasz_[r]);
+    bikes_allowed_per_section.emplace_back(
+        tt.route_bikes_allowed_per_section_[r]);
+    cars_allowed_per_section.emplace_back(
+        tt.route_cars_allowed_per_section_[r]);
+    for (auto const i : {0U, 1U}) {
+      bikes_allowed.set(to_idx(new_r) * 2U + i,
+                        tt.route_bikes_allowed_[to_idx(r) * 2U + i]);
+      cars_allowed.set(to_idx(new_r) * 2U + i,
+                       tt.route_cars_allowed_[to_idx(r) * 2U + i]);
+    }
+  }
+
+  auto location_routes = vecvec<location_idx_t, route_idx_t>{};
+  auto routes = std::vector<route_idx_t>{};
+  for (auto const l_routes : tt.location_routes_) {
+    routes.clear();
+    for (auto const r : l_routes) {
+      if (route_map[r] != route_idx_t::invalid()) {
+        routes.push_back(route_map[r]);
+      }
+    }
+    location_routes.emplace_back(routes);
+  }
+
+  tt.route_transport_ranges_ = std::move(transport_ranges);
+  tt.route_stop_time_ranges_ = std::move(times.route_stop_time_ranges_);
+  tt.route_stop_times_ = std::move(times.route_stop_times_);
+  tt.route_headways_ = std::move(times.route_headways_);
+  tt.route_location_seq_ = std::move(location_seq);
+  tt.route_clasz_ = std::move(route_clasz);
+  tt.route_section_clasz_ = std::move(section_clasz);
+  tt.route_bikes_allowed_ = std::move(bikes_allowed);
+  tt.route_cars_allowed_ = std::move(cars_allowed);
+  tt.route_bikes_allowed_per_section_ = std::move(bikes_allowed_per_section);
+  tt.route_cars_allowed_per_section_ = std::move(cars_allowed_per_section);
+  tt.location_routes_ = std::move(location_routes);
+}
+
+void compact_trip_transport_ranges(
+    timetable& tt,
+    vector_map<transport_idx_t, transport_idx_t> const& transport_map) {
+  auto trip_transport_ranges = paged_vecvec<trip_idx_t, transport_range_t>{};
+  for (auto i = 0U; i != tt.trip_transport_ranges_.size(); ++i) {
+    auto const trip = trip_idx_t{i};
+    trip_transport_ranges.emplace_back_empty();
+    for (auto const& [t, range] : tt.trip_transport_ranges_[trip]) {
+      if (transport_map[t] != transport_idx_t::invalid()) {
+        trip_transport_ranges[trip].push_back(
+            transport_range_t{transport_map[t], range});
+      }
+    }
+  }
+  tt.trip_transport_ranges_ = std::move(trip_transport_ranges);
+}
+
+void compact_route_bboxes(
+    shapes_storage& shapes,
+    vector_map<route_idx_t, route_idx_t> const& route_map) {
+  // Loaders without shapes support don't add bounding boxes for their routes.
+  auto const n_bboxes = std::min(shapes.route_bboxes_.size(), route_map.size());
+  auto segment_bboxes = std::vector<std::vector<geo::box>>{};
+  auto kept = 0U;
+  for (auto i = 0U; i != n_bboxes; ++i) {
+    auto const r = route_idx_t{i};
+    if (route_map[r] == route_idx_t::invalid()) {
+      continue;
+    }
+    shapes.route_bboxes_[route_map[r]] = shapes.route_bboxes_[r];
+    auto const bboxes = shapes.route_segment_bboxes_[r];
+    segment_bboxes.emplace_back(begin(bboxes), end(bboxes));
+    ++kept;
+  }
+
+  shapes.route_bboxes_.resize(kept);
+  shapes.route_segment_bboxes_.clear();
+  for (auto const& bboxes : segment_bboxes) {
+    shapes.route_segment_bboxes_.emplace_back(bboxes);
+  }
+}
+
+}  // namespace
+
+compaction_stats compact_transports(timetable& tt, shapes_storage* shapes) {
+  auto const timer = scoped_timer{"loader.compact_transports"};
+
+  auto const n_transports =
+      static_cast<unsigned>(tt.transport_traffic_days_.size());
+  auto transport_map = vector_map<transport_idx_t, transport_idx_t>{};
+  transport_map.resize(n_transports, transport_idx_t::invalid());
+  auto n_kept_transports = 0U;
+  for (auto t = transport_idx_t{0U}; t != tt.next_transport_idx(); ++t) {
+    if (!tt.bitfields_[tt.transport_traffic_days_[t]].none()) {
+      transport_map[t] = transport_idx_t{n_kept_transports++};
+    }
+  }
+
+  if (n_kept_transports == n_transports) {
+    return {};
+  }
+
+  auto route_map = vector_map<route_idx_t, route_idx_t>{};
+  route_map.resize(tt.n_routes(), route_idx_t::invalid());
+  auto n_kept_routes = 0U;
+  for (auto r = route_idx_t{0U}; r != tt.n_routes(); ++r) {
+    auto const active = utl::any_of(
+        tt.route_transport_ranges_[r], [&](transport_idx_t const t) {
+          return transport_map[t] != transport_idx_t::invalid();
+        });
+    if (active) {
+      route_map[r] = route_idx_t{n_kept_routes++};
+    }
+  }
+
+  auto const stats = compaction_stats{
+      .removed_transports_ = n_transports - n_kept_transports,
+      .removed_routes_ = tt.n_routes() - n_kept_routes};
+
+  if (shapes != nullptr) {
+    compact_route_bboxes(*shapes, route_map);
+  }
+  compact_trip_transport_ranges(tt, transport_map);
+  compact_route_data(tt, transport_map, route_map, n_kept_routes);
+  compact_transport_data(tt, transport_map, route_map);
+
+  log(log_lvl::info, "nigiri.loader.compact_transports",
+      "removed {} of {} transports, {} routes without transports",
+      stats.removed_transports_, n_transports, stats.removed_routes_);
+
+  return stats;
+}
+
+}  // namespace nigiri::loader
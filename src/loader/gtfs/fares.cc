@@ -579,6 +579,7 @@ void load_fares(timetable& tt,
               return a.rule_priority_ < b.rule_priority_;
             });
   utl::sort(f.fare_leg_join_rules_);
+  build_leg_rule_index(f);
 }
 
 }  // namespace nigiri::loader::gtfs
@@ -13,7 +13,6 @@
 
 #include "wyhash.h"
 
-#include "nigiri/loader/get_index.h"
 #include "nigiri/loader/gtfs/agency.h"
 #include "nigiri/loader/gtfs/calendar.h"
 #include "nigiri/loader/gtfs/calendar_date.h"
@@ -36,6 +35,7 @@
 #include "nigiri/loader/gtfs/translations.h"
 #include "nigiri/loader/gtfs/trip.h"
 #include "nigiri/loader/loader_interface.h"
+#include "nigiri/loader/partition_routes.h"
 #include "nigiri/loader/register.h"
 
 #include "nigiri/clasz.h"
@@ -131,6 +131,9 @@ void load_timetable(loader_config const& config,
   load_fares(tt, d, service, routes, stops);
   utl::verify(tt.fares_.size() == to_idx(src) + 1U, "fares: size={} src={}",
               tt.fares_.size(), src);
+  global_timer.set_attribute("nigiri.gtfs.n_stops", stops.size());
+  global_timer.set_attribute("nigiri.gtfs.n_routes", routes.size());
+  global_timer.set_attribute("nigiri.gtfs.n_trips", trip_data.data_.size());
 
   {
     for (auto const& t : trip_data.data_) {
@@ -226,9 +229,8 @@ void load_timetable(loader_config const& config,
     }
   }
 
-  hash_map<route_key_t, std::vector<std::vector<utc_trip>>, route_key_hash,
-           route_key_equals>
-      route_services;
+  hash_map<route_key_t, std::vector<utc_trip>, route_key_hash, route_key_equals>
+      route_trips;
 
   auto const noon_offsets =
       precompute_noon_offsets(tt, agencies, config.default_tz_);
@@ -287,21 +289,14 @@ void load_timetable(loader_config const& config,
                    .route_id_type_[trip_data.get(s.trips_.front()).route_]));
     auto const* bikes_allowed_seq = get_bikes_allowed_seq(s.trips_);
     auto const* cars_allowed_seq = get_cars_allowed_seq(s.trips_);
-    auto const it = route_services.find(
+    auto const it = route_trips.find(
         route_key_ptr_t{clasz, stop_seq, bikes_allowed_seq, cars_allowed_seq});
-    if (it != end(route_services)) {
-      for (auto& r : it->second) {
-        auto const idx = get_index(r, s);
-        if (idx.has_value()) {
-          r.insert(std::next(begin(r), static_cast<int>(*idx)), s);
-          return;
-        }
-      }
-      it->second.emplace_back(std::vector<utc_trip>{std::move(s)});
+    if (it != end(route_trips)) {
+      it->second.emplace_back(std::move(s));
     } else {
-      route_services.emplace(
+      route_trips.emplace(
           route_key_t{clasz, *stop_seq, *bikes_allowed_seq, *cars_allowed_seq},
-          std::vector<std::vector<utc_trip>>{{s}});
+          std::vector<utc_trip>{std::move(s)});
     }
   };
 
@@ -327,12 +322,13 @@ void load_timetable(loader_config const& config,
         progress_tracker->increment();
       }
     }
+    timer.set_attribute("nigiri.gtfs.n_route_keys", route_trips.size());
   }
 
   {
     progress_tracker->status("Stay Seated")
         .out_bounds(83.F, 85.F)
-        .in_high(route_services.size());
+        .in_high(route_trips.size());
     auto const timer = scoped_timer{"loader.gtfs.trips.block_id"};
 
     for (auto const& [_, blk] : trip_data.blocks_) {
@@ -385,6 +381,13 @@ void load_timetable(loader_config const& config,
         add_expanded_trip);
   }
 
+  auto const route_services = [&]() {
+    auto const timer = scoped_timer{"loader.gtfs.trips.partition_routes"};
+    auto routes_by_key = partition_routes_by_key(route_trips);
+    timer.set_attribute("nigiri.gtfs.n_route_keys", routes_by_key.size());
+    return routes_by_key;
+  }();
+
   {
     auto const timer = scoped_timer{"loader.gtfs.write_trips"};
 
@@ -468,22 +471,12 @@ void load_timetable(loader_config const& config,
 
         tt.finish_route();
 
-        auto const stop_times_begin = tt.route_stop_times_.size();
-        for (auto const [from, to] :
-             utl::pairwise(interval{std::size_t{0U}, key.stop_seq_.size()})) {
-          // Write departure times of all route services at stop i.
-          for (auto const& s : services) {
-            tt.route_stop_times_.emplace_back(s.utc_times_[from * 2]);
-          }
-
-          // Write arrival times of all route services at stop i+1.
-          for (auto const& s : services) {
-            tt.route_stop_times_.emplace_back(s.utc_times_[to * 2 - 1]);
-          }
-        }
-        auto const stop_times_end = tt.route_stop_times_.size();
-        tt.route_stop_time_ranges_.emplace_back(
-            interval{stop_times_begin, stop_times_end});
+        tt.add_route_stop_times(
+            static_cast<std::uint32_t>(services.size()),
+            static_cast<std::uint32_t>((key.stop_seq_.size() - 1U) * 2U),
+            [&](std::uint32_t const i, std::uint32_t const ev) {
+              return delta{services[i].utc_times_[ev]};
+            });
       }
 
       progress_tracker->increment();
@@ -499,6 +492,10 @@ void load_timetable(loader_config const& config,
       tt.location_routes_.emplace_back(location_routes[location_idx_t{l}]);
       assert(tt.location_routes_.size() == l + 1U);
     }
+
+    timer.set_attribute("nigiri.tt.n_routes", tt.n_routes());
+    timer.set_attribute("nigiri.tt.n_transports",
+                        tt.transport_traffic_days_.size());
   }
 
   {
@@ -329,7 +329,7 @@ std::pair<stops_map_t, seated_transfers_map_t> read_stops(
 
     auto const add_if_not_exists = [](auto bucket, footpath fp) {
       auto const it = utl::find_if(
-          bucket, [&](auto&& x) { return fp.target() == x.target_; });
+          bucket, [&](auto&& x) { return fp.target() == x.target(); });
       if (it == end(bucket)) {
         bucket.emplace_back(fp);
       }
@@ -1,6 +1,8 @@
 #include "nigiri/loader/init_finish.h"
 
+#include <algorithm>
 #include <execution>
+#include <limits>
 
 #include "utl/enumerate.h"
 
@@ -8,8 +10,10 @@
 
 #include "nigiri/loader/build_footpaths.h"
 #include "nigiri/loader/build_lb_graph.h"
+#include "nigiri/loader/compact_transports.h"
 #include "nigiri/loader/register.h"
 #include "nigiri/flex.h"
+#include "nigiri/logging.h"
 #include "nigiri/special_stations.h"
 #include "nigiri/timetable.h"
 
@@ -47,18 +51,31 @@ void build_location_tree(timetable& tt) {
 }
 
 void assign_stops_to_flex_areas(timetable& tt) {
+  build_flex_area_index(tt);
+
+  auto candidates = std::vector<location_idx_t>{};
+  auto positions = std::vector<geo::latlng>{};
+  auto is_in = bitvec{};
   for (auto const [i, bbox] : utl::enumerate(tt.flex_area_bbox_)) {
     auto const flex_area = flex_area_idx_t{i};
-    tt.flex_area_locations_.emplace_back(
-        std::initializer_list<location_idx_t>{});
+    candidates.clear();
+    positions.clear();
     tt.locations_.rtree_.search(
         bbox.min_.lnglat_float(), bbox.max_.lnglat_float(),
         [&](auto, auto, location_idx_t const l) {
-          if (is_in_flex_area(tt, flex_area, tt.locations_.coordinates_[l])) {
-            tt.flex_area_locations_.back().push_back(l);
-          }
+          candidates.push_back(l);
+          positions.push_back(tt.locations_.coordinates_[l]);
           return true;
         });
+
+    is_in_flex_area(tt, flex_area, positions, is_in);
+    tt.flex_area_locations_.emplace_back(
+        std::initializer_list<location_idx_t>{});
+    for (auto j = 0U; j != candidates.size(); ++j) {
+      if (is_in.test(j)) {
+        tt.flex_area_locations_.back().push_back(candidates[j]);
+      }
+    }
   }
 }
 
@@ -102,6 +119,57 @@ void assign_importance(timetable& tt) {
   }
 }
 
+void assign_hourly_events(timetable& tt) {
+  auto service_days = bitfield{};
+  auto transport_days = vector_map<transport_idx_t, std::uint32_t>{};
+  transport_days.resize(tt.transport_traffic_days_.size());
+  for (auto const [t, bf_idx] : utl::enumerate(tt.transport_traffic_days_)) {
+    auto const& bf = tt.bitfields_[bf_idx];
+    transport_days[transport_idx_t{t}] = static_cast<std::uint32_t>(bf.count());
+    service_days |= bf;
+  }
+
+  using histogram_t = std::array<std::uint64_t, 24U>;
+  auto deps = vector_map<location_idx_t, histogram_t>{};
+  auto arrs = vector_map<location_idx_t, histogram_t>{};
+  deps.resize(tt.n_locations());
+  arrs.resize(tt.n_locations());
+  for (auto r = route_idx_t{0U}; r != tt.n_routes(); ++r) {
+    auto const seq = tt.route_location_seq_[r];
+    auto const add = [&](histogram_t& h, stop_idx_t const i,
+                         event_type const ev_type) {
+      for (auto const t : tt.route_transport_ranges_[r]) {
+        auto const hour = tt.event_mam(r, t, i, ev_type).mam() / 60;
+        h[static_cast<std::size_t>(hour)] += transport_days[t];
+      }
+    };
+    for (auto i = stop_idx_t{0U}; i != seq.size(); ++i) {
+      auto const s = stop{seq[i]};
+      if (i + 1U != seq.size() && s.in_allowed()) {
+        add(deps[s.location_idx()], i, event_type::kDep);
+      }
+      if (i != 0U && s.out_allowed()) {
+        add(arrs[s.location_idx()], i, event_type::kArr);
+      }
+    }
+  }
+
+  auto const n_days = std::max(
+      std::uint64_t{1U}, static_cast<std::uint64_t>(service_days.count()));
+  auto const per_day = [&](auto const& in, auto& out) {
+    out.resize(tt.n_locations());
+    for (auto l = location_idx_t{0U}; l != tt.n_locations(); ++l) {
+      for (auto h = 0U; h != 24U; ++h) {
+        out[l][h] = static_cast<std::uint16_t>(
+            std::min(std::uint64_t{std::numeric_limits<std::uint16_t>::max()},
+                     (in[l][h] * 16U + n_days - 1U) / n_days));
+      }
+    }
+  };
+  per_day(deps, tt.location_hourly_departures_);
+  per_day(arrs, tt.location_hourly_arrivals_);
+}
+
 // Based on https://www.w3.org/TR/WCAG20/#relativeluminancedef
 float luminance(color_t color) {
   constexpr auto max = static_cast<float>(std::numeric_limits<uint8_t>::max());
@@ -153,7 +221,11 @@ void correct_color_contrast(timetable& tt) {
   }
 }
 
-void finalize(timetable& tt, finalize_options const opt) {
+void finalize(timetable& tt,
+              finalize_options const opt,
+              shapes_storage* shapes) {
+  auto const timer = scoped_timer{"loader.finalize"};
+
   tt.location_routes_.resize(tt.n_locations());
 
   {
@@ -184,13 +256,21 @@ void finalize(timetable& tt, finalize_options const opt) {
         });
   }
   build_footpaths(tt, opt);
-  build_lb_graph<direction::kForward>(tt, kDefaultProfile);
-  build_lb_graph<direction::kBackward>(tt, kDefaultProfile);
+  if (opt.merge_dupes_intra_src_ || opt.merge_dupes_inter_src_) {
+    compact_transports(tt, shapes);
+  }
+  build_lb_graphs(tt);
   build_location_tree(tt);
   assign_stops_to_flex_areas(tt);
   assign_importance(tt);
+  assign_hourly_events(tt);
   correct_color_contrast(tt);
 
+  timer.set_attribute("nigiri.tt.n_locations", tt.n_locations());
+  timer.set_attribute("nigiri.tt.n_routes", tt.n_routes());
+  timer.set_attribute("nigiri.tt.n_transports",
+                      tt.transport_traffic_days_.size());
+
   log(log_lvl::info, "nigiri.loader.finalize",
       "{} locations ({}% of idx space used)", tt.n_locations(),
       static_cast<double>(tt.n_locations()) / footpath::kMaxTarget * 100.0);
@@ -200,9 +280,12 @@ void finalize(timetable& tt,
               bool const adjust_footpaths,
               bool const merge_dupes_intra_src,
               bool const merge_dupes_inter_src,
-              std::uint16_t const max_footpath_length) {
-  finalize(tt, {adjust_footpaths, merge_dupes_intra_src, merge_dupes_inter_src,
-                max_footpath_length});
+              std::uint16_t const max_footpath_length,
+              shapes_storage* shapes) {
+  finalize(tt,
+           {adjust_footpaths, merge_dupes_intra_src, merge_dupes_inter_src,
+            max_footpath_length},
+           shapes);
 }
 
 }  // namespace nigiri::loader
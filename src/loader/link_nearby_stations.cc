@@ -1,5 +1,9 @@
 #include "nigiri/loader/link_nearby_stations.h"
 
+#include <vector>
+
+#include "utl/parallel_for.h"
+
 #include "geo/latlng.h"
 #include "geo/point_rtree.h"
 
@@ -30,56 +34,79 @@ struct dist_at {
 void link_nearby_stations(timetable& tt) {
   constexpr auto const kLinkNearbyMaxDistance = 300.0;  // [m];
   constexpr auto const kEqDist = 100.0;  // [m];
+  constexpr auto const kChunkSize = 4096U;
+
+  struct link {
+    location_idx_t from_, to_;
+    duration_t duration_;
+    bool equivalent_;
+  };
 
   auto const locations_rtree =
       geo::make_point_rtree(tt.locations_.coordinates_);
 
-  for (auto l_from_idx = location_idx_t{0U};
-       l_from_idx != tt.locations_.src_.size(); ++l_from_idx) {
-    auto const from_pos = tt.locations_.coordinates_[l_from_idx];
-    if (std::abs(from_pos.lat_) < 2.0 && std::abs(from_pos.lng_) < 2.0) {
-      continue;
-    }
-
-    auto const from_src = tt.locations_.src_[l_from_idx];
-    if (from_src == source_idx_t::invalid()) {
-      continue;  // no dummy stations
-    }
-
-    auto dist = dist_at{from_pos};
-    for (auto const& to_idx :
-         locations_rtree.in_radius(from_pos, kLinkNearbyMaxDistance)) {
-      auto const l_to_idx = location_idx_t{static_cast<unsigned>(to_idx)};
-      if (l_from_idx == l_to_idx) {
+  // Neighbor search in parallel (chunks of consecutive locations).
+  auto const n_locations = tt.locations_.src_.size();
+  auto const n_chunks = (n_locations + kChunkSize - 1U) / kChunkSize;
+  auto chunk_links = std::vector<std::vector<link>>(n_chunks);
+  utl::parallel_for_run(n_chunks, [&](std::size_t const chunk) {
+    auto& links = chunk_links[chunk];
+    auto const from = chunk * kChunkSize;
+    auto const to = std::min(from + kChunkSize, n_locations);
+    for (auto i = from; i != to; ++i) {
+      auto const l_from_idx = location_idx_t{static_cast<unsigned>(i)};
+      auto const from_pos = tt.locations_.coordinates_[l_from_idx];
+      if (std::abs(from_pos.lat_) < 2.0 && std::abs(from_pos.lng_) < 2.0) {
         continue;
       }
 
-      auto const to_src = tt.locations_.src_[l_to_idx];
-      auto const to_pos = tt.locations_.coordinates_[l_to_idx];
-      if (to_src == source_idx_t::invalid() /* no dummy stations */
-          || from_src == to_src /* don't short-circuit */) {
-        continue;
+      auto const from_src = tt.locations_.src_[l_from_idx];
+      if (from_src == source_idx_t::invalid()) {
+        continue;  // no dummy stations
       }
 
-      auto const from_transfer_time =
-          duration_t{tt.locations_.transfer_time_[l_from_idx]};
-      auto const to_transfer_time =
-          duration_t{tt.locations_.transfer_time_[l_to_idx]};
-      auto const walk_duration = duration_t{static_cast<unsigned>(
-          std::round(dist.get(to_pos) / (60 * kWalkSpeed)))};
-      auto const duration =
-          std::max({from_transfer_time, to_transfer_time, walk_duration});
-
-      tt.locations_.preprocessing_footpaths_out_[l_from_idx].emplace_back(
-          l_to_idx, duration);
-      tt.locations_.preprocessing_footpaths_in_[l_to_idx].emplace_back(
-          l_from_idx, duration);
-
-      if (dist.lt(to_pos, kEqDist)) {
-        tt.locations_.equivalences_[l_from_idx].emplace_back(l_to_idx);
+      auto dist = dist_at{from_pos};
+      for (auto const& to_idx :
+           locations_rtree.in_radius(from_pos, kLinkNearbyMaxDistance)) {
+        auto const l_to_idx = location_idx_t{static_cast<unsigned>(to_idx)};
+        if (l_from_idx == l_to_idx) {
+          continue;
+        }
+
+        auto const to_src = tt.locations_.src_[l_to_idx];
+        auto const to_pos = tt.locations_.coordinates_[l_to_idx];
+        if (to_src == source_idx_t::invalid() /* no dummy stations */
+            || from_src == to_src /* don't short-circuit */) {
+          continue;
+        }
+
+        auto const from_transfer_time =
+            duration_t{tt.locations_.transfer_time_[l_from_idx]};
+        auto const to_transfer_time =
+            duration_t{tt.locations_.transfer_time_[l_to_idx]};
+        auto const walk_duration = duration_t{static_cast<unsigned>(
+            std::round(dist.get(to_pos) / (60 * kWalkSpeed)))};
+        auto const duration =
+            std::max({from_transfer_time, to_transfer_time, walk_duration});
+
+        links.push_back({l_from_idx, l_to_idx, duration,
+                         static_cast<bool>(dist.lt(to_pos, kEqDist))});
+      }
+    }
+  });
+
+  // Sequential merge in location order: same output as a serial run.
+  for (auto const& links : chunk_links) {
+    for (auto const& l : links) {
+      tt.locations_.preprocessing_footpaths_out_[l.from_].emplace_back(
+          l.to_, l.duration_);
+      tt.locations_.preprocessing_footpaths_in_[l.to_].emplace_back(
+          l.from_, l.duration_);
+      if (l.equivalent_) {
+        tt.locations_.equivalences_[l.from_].emplace_back(l.to_);
       }
     }
   }
 }
 
-}  // namespace nigiri::loader
\ No newline at end of file
+}  // namespace nigiri::loader
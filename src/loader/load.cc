@@ -68,7 +68,7 @@ timetable load(std::vector<timetable_source> const& sources,
   }
 
   progress_tracker->status("Finalizing").out_bounds(98.F, 100.F).in_high(1);
-  finalize(tt, finalize_opt);
+  finalize(tt, finalize_opt, shapes);
 
   return tt;
 }
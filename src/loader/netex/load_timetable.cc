@@ -1,6 +1,6 @@
 #include "nigiri/loader/netex/load_timetable.h"
 
-#include "nigiri/loader/get_index.h"
+#include "nigiri/loader/partition_routes.h"
 
 #include <filesystem>
 #include <ranges>
@@ -1557,25 +1557,17 @@ void load_timetable(loader_config const& config,
       },
       pt->update_fn());
 
-  auto route_services =
-      hash_map<gtfs::route_key_t, std::vector<std::vector<utc_trip>>,
-               gtfs::route_key_hash, gtfs::route_key_equals>{};
+  auto route_trips = hash_map<gtfs::route_key_t, std::vector<utc_trip>,
+                              gtfs::route_key_hash, gtfs::route_key_equals>{};
   auto const add_expanded_trip = [&](utc_trip const& s) {
     auto const c =
         gtfs::to_clasz(to_idx(tt.route_ids_[src].route_id_type_[s.route_id_]));
-    auto const it = route_services.find(gtfs::route_key_ptr_t{c, &s.stop_seq_});
-    if (it != end(route_services)) {
-      for (auto& route : it->second) {
-        auto const idx = get_index(route, s);
-        if (idx.has_value()) {
-          route.insert(std::next(begin(route), static_cast<int>(*idx)), s);
-          return;
-        }
-      }
-      it->second.emplace_back(std::vector<utc_trip>{s});
+    auto const it = route_trips.find(gtfs::route_key_ptr_t{c, &s.stop_seq_});
+    if (it != end(route_trips)) {
+      it->second.emplace_back(s);
     } else {
-      route_services.emplace(gtfs::route_key_t{c, s.stop_seq_, {}, {}},
-                             std::vector<std::vector<utc_trip>>{{s}});
+      route_trips.emplace(gtfs::route_key_t{c, s.stop_seq_, {}, {}},
+                          std::vector<utc_trip>{s});
     }
   };
 
@@ -1644,6 +1636,11 @@ void load_timetable(loader_config const& config,
         [&](netex::utc_trip&& x) { add_expanded_trip(std::move(x)); });
   }
 
+  auto const route_services = [&]() {
+    auto const timer = scoped_timer{"loader.netex.partition_routes"};
+    return partition_routes_by_key(route_trips);
+  }();
+
   {
     auto const timer = scoped_timer{"loader.gtfs.write_trips"};
 
@@ -1731,22 +1728,12 @@ void load_timetable(loader_config const& config,
 
         tt.finish_route();
 
-        auto const stop_times_begin = tt.route_stop_times_.size();
-        for (auto const [from, to] :
-             utl::pairwise(interval{std::size_t{0U}, key.stop_seq_.size()})) {
-          // Write departure times of all route services at stop i.
-          for (auto const& s : services) {
-            tt.route_stop_times_.emplace_back(s.utc_times_[from * 2]);
-          }
-
-          // Write arrival times of all route services at stop i+1.
-          for (auto const& s : services) {
-            tt.route_stop_times_.emplace_back(s.utc_times_[to * 2 - 1]);
-          }
-        }
-        auto const stop_times_end = tt.route_stop_times_.size();
-        tt.route_stop_time_ranges_.emplace_back(
-            interval{stop_times_begin, stop_times_end});
+        tt.add_route_stop_times(
+            static_cast<std::uint32_t>(services.size()),
+            static_cast<std::uint32_t>((key.stop_seq_.size() - 1U) * 2U),
+            [&](std::uint32_t const i, std::uint32_t const ev) {
+              return delta{services[i].utc_times_[ev]};
+            });
       }
 
       pt->increment();
@@ -1,11 +1,23 @@
 #include "nigiri/logging.h"
 
+#include "nigiri/get_otel_tracer.h"
+
 namespace nigiri {
 
 log_lvl s_verbosity = log_lvl::debug;
 
+struct scoped_timer::span {
+  explicit span(std::string const& name)
+      : span_{get_otel_tracer()->StartSpan(name)}, scope_{span_} {}
+
+  opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span_;
+  opentelemetry::trace::Scope scope_;
+};
+
 scoped_timer::scoped_timer(std::string name)
-    : name_{std::move(name)}, start_{std::chrono::steady_clock::now()} {
+    : name_{std::move(name)},
+      start_{std::chrono::steady_clock::now()},
+      span_{std::make_unique<span>(name_)} {
   log(log_lvl::info, name_.c_str(), "starting {}", std::string_view{name_});
 }
 
@@ -17,6 +29,12 @@ scoped_timer::~scoped_timer() {
       1000.0;
   log(log_lvl::info, name_.c_str(), "finished {} {}ms", std::string_view{name_},
       t);
+  span_->span_->End();
+}
+
+void scoped_timer::set_attribute(std::string_view const key,
+                                 std::uint64_t const value) const {
+  span_->span_->SetAttribute(key, value);
 }
 
 }  // namespace nigiri
@@ -0,0 +1,166 @@
+#include "nigiri/mapped_timetable.h"
+
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cista/hash.h"
+#include "cista/mmap.h"
+#include "cista/serialization.h"
+#include "cista/targets/file.h"
+
+#include "utl/verify.h"
+
+#include "nigiri/logging.h"
+
+namespace nigiri {
+
+// Same as cista::read / cista::write (used by timetable::read/write).
+constexpr auto const kMode =
+    cista::mode::WITH_INTEGRITY | cista::mode::WITH_STATIC_VERSION;
+
+namespace {
+
+bool verify_checksum(std::filesystem::path const& p) {
+  // Separate shared read-only mapping: hashes the file as written, not the
+  // in-place deserialized (pointer fixed-up) private copy.
+  auto const f = cista::mmap{p.generic_string().c_str(),
+                             cista::mmap::protection::READ};
+  auto const data_start = cista::data_start(kMode);
+  utl::verify(f.size() >= data_start, "timetable file {} too small",
+              p.generic_string());
+  auto stored = cista::hash_t{};
+  std::memcpy(&stored, f.data() + data_start - sizeof(cista::hash_t),
+              sizeof(cista::hash_t));
+  auto const computed = cista::hash(std::string_view{
+      reinterpret_cast<char const*>(f.data() + data_start),
+      f.size() - data_start});
+  auto const ok = stored == computed;
+  if (!ok) {
+    log(log_lvl::error, "mapped_timetable", "checksum mismatch: {}",
+        p.generic_string());
+  }
+  return ok;
+}
+
+std::future<bool> ready(bool const value) {
+  auto p = std::promise<bool>{};
+  p.set_value(value);
+  return p.get_future();
+}
+
+}  // namespace
+
+mapped_timetable mapped_timetable::read(std::filesystem::path const& p,
+                                        options const& opt) {
+  auto m = mapped_timetable{};
+
+  switch (opt.checksum_) {
+    case checksum_check::kEager:
+      utl::verify(verify_checksum(p), "timetable checksum mismatch: {}",
+                  p.generic_string());
+      m.checksum_ok_ = ready(true);
+      break;
+    case checksum_check::kBackground:
+      m.checksum_ok_ = std::async(std::launch::async,
+                                  [p]() { return verify_checksum(p); });
+      break;
+    case checksum_check::kSkip: m.checksum_ok_ = ready(true); break;
+  }
+
+#ifdef _WIN32
+  // No copy-on-write file mapping here: fall back to a private buffer.
+  (void)opt.populate_;
+  (void)opt.will_need_;
+  m.buf_ = cista::file{p.generic_string().c_str(), "r"}.content();
+  auto const begin = m.buf_.data();
+  m.size_ = m.buf_.size();
+#else
+  auto const fd = ::open(p.generic_string().c_str(), O_RDONLY);
+  utl::verify(fd != -1, "could not open timetable {}", p.generic_string());
+
+  struct stat st{};
+  auto const stat_ret = ::fstat(fd, &st);
+  if (stat_ret == -1) {
+    ::close(fd);
+  }
+  utl::verify(stat_ret != -1, "could not stat timetable {}",
+              p.generic_string());
+  m.size_ = static_cast<std::size_t>(st.st_size);
+
+  auto flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+  if (opt.populate_) {
+    flags |= MAP_POPULATE;
+  }
+#endif
+  m.addr_ =
+      ::mmap(nullptr, m.size_, PROT_READ | PROT_WRITE, flags, fd, 0);
+  ::close(fd);  // the mapping keeps its own reference to the file
+  utl::verify(m.addr_ != MAP_FAILED, "could not map timetable {}",
+              p.generic_string());
+
+  ::madvise(m.addr_, m.size_, opt.will_need_ ? MADV_WILLNEED : MADV_RANDOM);
+  auto const begin = static_cast<std::uint8_t*>(m.addr_);
+#endif
+
+  m.tt_ = cista::deserialize<timetable, kMode | cista::mode::SKIP_INTEGRITY>(
+      begin, begin + m.size_);
+  return m;
+}
+
+mapped_timetable::mapped_timetable(mapped_timetable&& o) noexcept
+    : addr_{std::exchange(o.addr_, nullptr)},
+      size_{std::exchange(o.size_, 0U)},
+#ifdef _WIN32
+      buf_{std::move(o.buf_)},
+#endif
+      tt_{std::exchange(o.tt_, nullptr)},
+      checksum_ok_{std::move(o.checksum_ok_)} {
+}
+
+mapped_timetable& mapped_timetable::operator=(mapped_timetable&& o) noexcept {
+  if (this != &o) {
+    unmap();
+    addr_ = std::exchange(o.addr_, nullptr);
+    size_ = std::exchange(o.size_, 0U);
+#ifdef _WIN32
+    buf_ = std::move(o.buf_);
+#endif
+    tt_ = std::exchange(o.tt_, nullptr);
+    checksum_ok_ = std::move(o.checksum_ok_);
+  }
+  return *this;
+}
+
+mapped_timetable::~mapped_timetable() { unmap(); }
+
+bool mapped_timetable::checksum_ok() {
+  if (!checksum_ok_.valid()) {
+    return true;
+  }
+  auto const ok = checksum_ok_.get();
+  checksum_ok_ = ready(ok);
+  return ok;
+}
+
+void mapped_timetable::unmap() {
+  if (checksum_ok_.valid()) {
+    checksum_ok_.wait();
+  }
+  tt_ = nullptr;  // containers point into the mapping, nothing to free
+#ifndef _WIN32
+  if (addr_ != nullptr) {
+    ::munmap(addr_, size_);
+    addr_ = nullptr;
+  }
+#endif
+}
+
+}  // namespace nigiri
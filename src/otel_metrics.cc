@@ -0,0 +1,112 @@
+#include "nigiri/otel_metrics.h"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include "opentelemetry/context/runtime_context.h"
+#include "opentelemetry/metrics/sync_instruments.h"
+
+#include "nigiri/get_otel_tracer.h"
+#include "nigiri/routing/search.h"
+
+namespace nigiri {
+
+namespace {
+
+using histogram_ptr = opentelemetry::nostd::unique_ptr<
+    opentelemetry::metrics::Histogram<double>>;
+
+using ms_t = std::chrono::duration<double, std::milli>;
+
+struct instruments {
+  explicit instruments(
+      opentelemetry::nostd::shared_ptr<opentelemetry::metrics::Meter> meter)
+      : meter_{std::move(meter)},
+        search_execute_time_{meter_->CreateDoubleHistogram(
+            "nigiri.search.execute_time", "search execute time", "ms")},
+        search_lb_time_{meter_->CreateDoubleHistogram(
+            "nigiri.search.lb_time", "lower bound computation time", "ms")},
+        search_start_label_time_{meter_->CreateDoubleHistogram(
+            "nigiri.search.start_label_time", "start label time", "ms")},
+        search_algo_time_{meter_->CreateDoubleHistogram(
+            "nigiri.search.algo_time", "routing algorithm time", "ms")},
+        search_reconstruct_time_{meter_->CreateDoubleHistogram(
+            "nigiri.search.reconstruct_time", "journey reconstruction time",
+            "ms")},
+        search_interval_extensions_{meter_->CreateDoubleHistogram(
+            "nigiri.search.interval_extensions",
+            "search interval extensions per query", "{extension}")},
+        rt_update_time_{meter_->CreateDoubleHistogram(
+            "nigiri.rt.update_time", "real-time update processing time",
+            "ms")},
+        rt_update_lag_{meter_->CreateDoubleHistogram(
+            "nigiri.rt.update_lag",
+            "time between feed timestamp and applying the update", "s")} {}
+
+  opentelemetry::nostd::shared_ptr<opentelemetry::metrics::Meter> meter_;
+  histogram_ptr search_execute_time_;
+  histogram_ptr search_lb_time_;
+  histogram_ptr search_start_label_time_;
+  histogram_ptr search_algo_time_;
+  histogram_ptr search_reconstruct_time_;
+  histogram_ptr search_interval_extensions_;
+  histogram_ptr rt_update_time_;
+  histogram_ptr rt_update_lag_;
+};
+
+// Like the tracer, the meter is looked up on every call. The instruments are
+// recreated when the global meter provider was set or replaced in between:
+// only then is the exclusive lock taken.
+std::shared_ptr<instruments> get_instruments() {
+  static auto mutex = std::shared_mutex{};
+  static auto cached = std::shared_ptr<instruments>{};
+  auto meter = get_otel_meter();
+  {
+    auto const lock = std::shared_lock{mutex};
+    if (cached != nullptr && cached->meter_.get() == meter.get()) {
+      return cached;
+    }
+  }
+  auto const lock = std::unique_lock{mutex};
+  if (cached == nullptr || cached->meter_.get() != meter.get()) {
+    cached = std::make_shared<instruments>(std::move(meter));
+  }
+  return cached;
+}
+
+}  // namespace
+
+void record_search_metrics(std::string_view const algo,
+                           routing::search_stats const& s) {
+  auto const m_ptr = get_instruments();
+  auto& m = *m_ptr;
+  auto const ctx = opentelemetry::context::RuntimeContext::GetCurrent();
+  auto const record = [&](histogram_ptr const& h, double const value) {
+    h->Record(value, {{"algo", algo}}, ctx);
+  };
+  record(m.search_execute_time_, ms_t{s.execute_time_}.count());
+  record(m.search_lb_time_, static_cast<double>(s.lb_time_));
+  record(m.search_start_label_time_, ms_t{s.start_label_time_}.count());
+  record(m.search_algo_time_, ms_t{s.algo_time_}.count());
+  record(m.search_reconstruct_time_, ms_t{s.reconstruct_time_}.count());
+  record(m.search_interval_extensions_,
+         static_cast<double>(s.interval_extensions_));
+}
+
+void record_rt_update_metrics(std::string_view const kind,
+                              std::string_view const tag,
+                              std::chrono::microseconds const update_time,
+                              std::optional<std::chrono::seconds> const lag) {
+  auto const m_ptr = get_instruments();
+  auto& m = *m_ptr;
+  auto const ctx = opentelemetry::context::RuntimeContext::GetCurrent();
+  m.rt_update_time_->Record(ms_t{update_time}.count(),
+                            {{"kind", kind}, {"tag", tag}}, ctx);
+  if (lag.has_value()) {
+    m.rt_update_lag_->Record(static_cast<double>(lag->count()),
+                             {{"kind", kind}, {"tag", tag}}, ctx);
+  }
+}
+
+}  // namespace nigiri
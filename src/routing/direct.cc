@@ -151,8 +151,7 @@ void get_direct(timetable const& tt,
         for (auto const day : day_indices) {
           for (auto it = begin(start_events); it != end(start_events); ++it) {
             auto const ev = *it;
-            auto const t_offset =
-                static_cast<std::size_t>(&*it - start_events.data());
+            auto const t_offset = route_event_times::index(it);
             auto const t = tt.route_transport_ranges_[r][t_offset];
             auto const ev_day_offset = ev.days();
             auto const start_day =
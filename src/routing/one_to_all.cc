@@ -9,6 +9,7 @@
 #include "utl/verify.h"
 
 #include "nigiri/for_each_meta.h"
+#include "nigiri/get_otel_tracer.h"
 #include "nigiri/routing/raptor/raptor.h"
 #include "nigiri/routing/start_times.h"
 
@@ -28,6 +29,12 @@ void run_raptor(raptor<SearchDir, Rt, kVias, search_mode::kOneToAll>&& algo,
                 timetable const& tt,
                 unixtime_t const& start_time,
                 query const& q) {
+  auto span = get_otel_tracer()->StartSpan(
+      "one_to_all", {{"nigiri.one_to_all.rt", Rt},
+                     {"nigiri.one_to_all.fwd", SearchDir == direction::kForward},
+                     {"nigiri.one_to_all.n_starts", q.start_.size()}});
+  auto scope = opentelemetry::trace::Scope{span};
+
   auto results = pareto_set<journey>{};
   algo.next_start_time();
   for (auto const& s : q.start_) {
@@ -48,6 +55,8 @@ void run_raptor(raptor<SearchDir, Rt, kVias, search_mode::kOneToAll>&& algo,
 
   algo.execute(start_time, q.max_transfers_, worst_time_at_dest, q.prf_idx_,
                results);
+
+  set_span_attributes(*span, "nigiri.algo.", algo.get_stats().to_map());
 }
 
 template <direction SearchDir, bool Rt>
@@ -5,6 +5,9 @@
 #include "utl/sorted_diff.h"
 #include "utl/timing.h"
 
+#include "nigiri/common/parallel_for.h"
+#include "nigiri/get_otel_tracer.h"
+#include "nigiri/otel_metrics.h"
 #include "nigiri/routing/get_earliest_transport.h"
 #include "nigiri/rt/frun.h"
 
@@ -257,6 +260,10 @@ routing_result pong(timetable const& tt,
                     std::optional<std::chrono::seconds> timeout) {
   constexpr auto kFwd = (SearchDir == direction::kForward);
 
+  auto span = get_otel_tracer()->StartSpan(
+      "pong", {{"nigiri.pong.rt", Rt}, {"nigiri.pong.fwd", kFwd}});
+  auto scope = opentelemetry::trace::Scope{span};
+
   q.sanitize(tt);
 
   auto const processing_start_time = std::chrono::steady_clock::now();
@@ -278,26 +285,54 @@ routing_result pong(timetable const& tt,
                     tt.internal_interval().from_)
                     .count()};
 
+  // ============
+  // LOWER BOUNDS
+  // ------------
+  // Both directions are independent: with parallel_lower_bounds_, they are
+  // computed through the executor of the search state (if one is set).
+  auto pong_q = q;
+  pong_q.flip_dir();
+
+  UTL_START_TIMING(lb);
+  auto& ping_lb = s_state.travel_time_lower_bound_;
+  auto pong_lb = std::vector<std::uint16_t>{};
+  parallel_for(
+      q.parallel_lower_bounds_ ? s_state.parallel_for_ : parallel_for_fn{}, 2U,
+      [&](std::size_t const i) {
+        if (i == 0U) {
+          dijkstra(tt, q,
+                   (kFwd ? tt.fwd_search_lb_graph_[q.prf_idx_]
+                         : tt.bwd_search_lb_graph_[q.prf_idx_]),
+                   (rtt == nullptr
+                        ? nullptr
+                        : &(kFwd ? rtt->fwd_search_lb_graph_has_edges_
+                                 : rtt->bwd_search_lb_graph_has_edges_)),
+                   (rtt == nullptr ? nullptr
+                                   : &(kFwd ? rtt->fwd_search_lb_graph_
+                                            : rtt->bwd_search_lb_graph_)),
+                   ping_lb);
+        } else {
+          dijkstra(tt, pong_q,
+                   (kFwd ? tt.bwd_search_lb_graph_[q.prf_idx_]
+                         : tt.fwd_search_lb_graph_[q.prf_idx_]),
+                   (rtt == nullptr
+                        ? nullptr
+                        : &(kFwd ? rtt->bwd_search_lb_graph_has_edges_
+                                 : rtt->fwd_search_lb_graph_has_edges_)),
+                   (rtt == nullptr ? nullptr
+                                   : &(kFwd ? rtt->bwd_search_lb_graph_
+                                            : rtt->fwd_search_lb_graph_)),
+                   pong_lb);
+        }
+      });
+  UTL_STOP_TIMING(lb);
+
   // ====
   // PING
   // ----
-  UTL_START_TIMING(ping_lb);
-  auto ping_lb = std::vector<std::uint16_t>{};
-  dijkstra(tt, q,
-           (kFwd ? tt.fwd_search_lb_graph_[q.prf_idx_]
-                 : tt.bwd_search_lb_graph_[q.prf_idx_]),
-           (rtt == nullptr ? nullptr
-                           : &(kFwd ? rtt->fwd_search_lb_graph_has_edges_
-                                    : rtt->bwd_search_lb_graph_has_edges_)),
-           (rtt == nullptr ? nullptr
-                           : &(kFwd ? rtt->fwd_search_lb_graph_
-                                    : rtt->bwd_search_lb_graph_)),
-           ping_lb);
-  UTL_STOP_TIMING(ping_lb);
-
-  auto ping_dist_to_dest = std::vector<std::uint16_t>{};
-  auto ping_is_dest = bitvec{};
-  auto ping_is_via = std::array<bitvec, kMaxVias>{};
+  auto& ping_dist_to_dest = s_state.dist_to_dest_;
+  auto& ping_is_dest = s_state.is_destination_;
+  auto& ping_is_via = s_state.is_via_;
   collect_destinations(tt, q.destination_, q.dest_match_mode_, ping_is_dest,
                        ping_dist_to_dest);
   for (auto const [i, via] : utl::enumerate(q.via_stops_)) {
@@ -326,20 +361,6 @@ routing_result pong(timetable const& tt,
   // ----
   q.flip_dir();
 
-  UTL_START_TIMING(pong_lb);
-  auto pong_lb = std::vector<std::uint16_t>{};
-  dijkstra(tt, q,
-           (kFwd ? tt.bwd_search_lb_graph_[q.prf_idx_]
-                 : tt.fwd_search_lb_graph_[q.prf_idx_]),
-           (rtt == nullptr ? nullptr
-                           : &(kFwd ? rtt->bwd_search_lb_graph_has_edges_
-                                    : rtt->fwd_search_lb_graph_has_edges_)),
-           (rtt == nullptr ? nullptr
-                           : &(kFwd ? rtt->bwd_search_lb_graph_
-                                    : rtt->fwd_search_lb_graph_)),
-           pong_lb);
-  UTL_STOP_TIMING(pong_lb);
-
   auto pong_dist_to_dest = std::vector<std::uint16_t>{};
   auto pong_is_dest = bitvec{};
   collect_destinations(tt, q.destination_, q.dest_match_mode_, pong_is_dest,
@@ -372,13 +393,13 @@ routing_result pong(timetable const& tt,
   // ========
   // >> PLAY!
   // --------
-  auto starts = std::vector<start>{};
+  auto& starts = s_state.starts_;
+  auto ping_results = pareto_set<journey>{};
   auto result = routing_result{
       .journeys_ = &s_state.results_,
       .interval_ = search_interval,
       .search_stats_ = {.lb_time_ =
-                            static_cast<std::uint64_t>(UTL_TIMING_MS(ping_lb)) +
-                            static_cast<std::uint64_t>(UTL_TIMING_MS(pong_lb))},
+                            static_cast<std::uint64_t>(UTL_TIMING_MS(lb))},
       .algo_stats_ = {}};
   auto start_time =
       kFwd ? search_interval.from_ : search_interval.to_ - duration_t{1};
@@ -426,7 +447,7 @@ routing_result pong(timetable const& tt,
     }
     auto const worst_time_at_dest =
         start_time + (kFwd ? 1 : -1) * (q.max_travel_time_ + duration_t{1});
-    auto ping_results = pareto_set<journey>{};
+    ping_results.clear();
     ping.execute(start_time, q.max_transfers_, worst_time_at_dest, q.prf_idx_,
                  ping_results);
     if (ping_results.empty()) {
@@ -487,6 +508,7 @@ routing_result pong(timetable const& tt,
       trace_pong("---- HIT [updating ping start time {} -> {}]\n",
                  ping_j.start_time_, match->dest_time_);
       if (match->legs_.empty() && !match->error_) {
+        s_state.reuse_leg_buffer(*match);
         pong.reconstruct(q, *match);
       }
       ping_j.start_time_ = match->dest_time_;
@@ -542,6 +564,12 @@ routing_result pong(timetable const& tt,
       std::chrono::duration_cast<std::chrono::milliseconds>(
           (std::chrono::steady_clock::now() - processing_start_time));
 
+  span->SetAttribute("nigiri.search.n_results", s_state.results_.size());
+  span->SetAttribute("nigiri.search.timeout_reached", is_timeout_reached());
+  set_span_attributes(*span, "nigiri.search.", result.search_stats_.to_map());
+  set_span_attributes(*span, "nigiri.algo.", result.algo_stats_);
+  record_search_metrics("pong", result.search_stats_);
+
   for (auto& j : s_state.results_) {
     auto const swap = [](location_idx_t const l) -> location_idx_t {
       switch (to_idx(l)) {
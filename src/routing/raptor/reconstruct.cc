@@ -759,14 +759,20 @@ void reconstruct_journey_with_vias(timetable const& tt,
     }
   }
 
-  optimize_footpaths<SearchDir>(tt, rtt, q, j);
-  specify_td_offsets<SearchDir>(q, j);
-
 #if defined(NIGIRI_TRACE_RECUSTRUCT)
   j.print(std::cout, tt, true);
 #endif
 }
 
+template <direction SearchDir>
+void finalize_journey(timetable const& tt,
+                      rt_timetable const* rtt,
+                      query const& q,
+                      journey& j) {
+  optimize_footpaths<SearchDir>(tt, rtt, q, j);
+  specify_td_offsets<SearchDir>(q, j);
+}
+
 template <direction SearchDir>
 void reconstruct_journey(timetable const& tt,
                          rt_timetable const* rtt,
@@ -774,31 +780,50 @@ void reconstruct_journey(timetable const& tt,
                          raptor_state const& raptor_state,
                          journey& j,
                          date::sys_days const base,
-                         day_idx_t const base_day_idx) {
+                         day_idx_t const base_day_idx,
+                         bool const finalize) {
   static_assert(kMaxVias == 2,
                 "reconstruct.cc needs to be adjusted for kMaxVias");
 
   switch (q.via_stops_.size()) {
     case 0:
-      return reconstruct_journey_with_vias<SearchDir, 0>(
-          tt, rtt, q, raptor_state, j, base, base_day_idx);
+      reconstruct_journey_with_vias<SearchDir, 0>(tt, rtt, q, raptor_state, j,
+                                                  base, base_day_idx);
+      break;
     case 1:
-      return reconstruct_journey_with_vias<SearchDir, 1>(
-          tt, rtt, q, raptor_state, j, base, base_day_idx);
+      reconstruct_journey_with_vias<SearchDir, 1>(tt, rtt, q, raptor_state, j,
+                                                  base, base_day_idx);
+      break;
     case 2:
-      return reconstruct_journey_with_vias<SearchDir, 2>(
-          tt, rtt, q, raptor_state, j, base, base_day_idx);
+      reconstruct_journey_with_vias<SearchDir, 2>(tt, rtt, q, raptor_state, j,
+                                                  base, base_day_idx);
+      break;
+    default: std::unreachable();
+  }
+
+  if (finalize) {
+    finalize_journey<SearchDir>(tt, rtt, q, j);
   }
-  std::unreachable();
 }
 
+template void finalize_journey<direction::kForward>(timetable const&,
+                                                    rt_timetable const*,
+                                                    query const&,
+                                                    journey&);
+
+template void finalize_journey<direction::kBackward>(timetable const&,
+                                                     rt_timetable const*,
+                                                     query const&,
+                                                     journey&);
+
 template void reconstruct_journey<direction::kForward>(timetable const&,
                                                        rt_timetable const*,
                                                        query const&,
                                                        raptor_state const&,
                                                        journey&,
                                                        date::sys_days const,
-                                                       day_idx_t const);
+                                                       day_idx_t const,
+                                                       bool);
 
 template void reconstruct_journey<direction::kBackward>(timetable const&,
                                                         rt_timetable const*,
@@ -806,6 +831,7 @@ template void reconstruct_journey<direction::kBackward>(timetable const&,
                                                         raptor_state const&,
                                                         journey&,
                                                         date::sys_days const,
-                                                        day_idx_t const);
+                                                        day_idx_t const,
+                                                        bool);
 
 }  // namespace nigiri::routing
@@ -9,6 +9,7 @@
 #include "fmt/format.h"
 #include "fmt/ranges.h"
 
+#include "utl/helpers/algorithm.h"
 #include "utl/overloaded.h"
 #include "utl/to_vec.h"
 #include "utl/verify.h"
@@ -150,4 +151,40 @@ routing_result raptor_search(
   }
 }
 
+void reconstruct_legs(timetable const& tt,
+                      rt_timetable const* rtt,
+                      search_state& s_state,
+                      raptor_state& r_state,
+                      query const& q,
+                      direction const search_dir,
+                      std::span<journey> journeys) {
+  for (auto& j : journeys) {
+    if (!j.legs_.empty()) {
+      continue;
+    }
+
+    auto single = q;
+    single.start_time_ =
+        interval<unixtime_t>{j.start_time_, j.start_time_ + duration_t{1}};
+    single.min_connection_count_ = 0U;
+    single.extend_interval_earlier_ = false;
+    single.extend_interval_later_ = false;
+    single.max_transfers_ = j.transfers_;
+    single.slow_direct_ = false;
+    single.reconstruct_legs_ = true;
+
+    auto const result =
+        raptor_search(tt, rtt, s_state, r_state, std::move(single), search_dir);
+    auto const match = utl::find_if(*result.journeys_, [&](journey const& x) {
+      return x.start_time_ == j.start_time_ && x.dest_time_ == j.dest_time_ &&
+             x.transfers_ == j.transfers_ && x.dest_ == j.dest_;
+    });
+    if (match == end(*result.journeys_)) {
+      j.error_ = true;
+      continue;
+    }
+    j = *match;
+  }
+}
+
 }  // namespace nigiri::routing
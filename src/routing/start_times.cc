@@ -60,9 +60,11 @@ void add_start_times_at_stop(direction const search_dir,
 
   auto const& transport_range = tt.route_transport_ranges_[route_idx];
   for (auto t = transport_range.from_; t != transport_range.to_; ++t) {
-    auto const& traffic_days =
-        rtt == nullptr ? tt.bitfields_[tt.transport_traffic_days_[t]]
-                       : rtt->bitfields_[rtt->transport_traffic_days_[t]];
+    auto const is_active = [&](std::size_t const day) {
+      return rtt == nullptr
+                 ? tt.bitfields_[tt.transport_traffic_days_[t]].test(day)
+                 : rtt->bitfields_[rtt->transport_traffic_days_[t]].test(day);
+    };
     auto const stop_time =
         tt.event_mam(t, stop_idx,
                      (search_dir == direction::kForward ? event_type::kDep
@@ -77,7 +79,7 @@ void add_start_times_at_stop(direction const search_dir,
         iv_at_stop.from_, iv_at_stop.to_, t, tt.transport_name(t), stop_time,
         day_offset, stop_time_mam);
     for (auto day = first_day_idx; day <= last_day_idx; ++day) {
-      if (traffic_days.test(to_idx(day - day_offset)) &&
+      if (is_active(to_idx(day - day_offset)) &&
           iv_at_stop.contains(tt.to_unixtime(day, stop_time_mam))) {
         auto const ev_time = tt.to_unixtime(day, stop_time_mam);
         auto const d = get_duration(search_dir, ev_time, offset);
@@ -113,7 +115,7 @@ void add_start_times_at_stop(direction const search_dir,
             "in_interval={}\n",
             day, day_offset,
             tt.date_range_.from_ + to_idx(day - day_offset) * 1_days,
-            traffic_days.test(to_idx(day)),
+            is_active(to_idx(day)),
             iv_at_stop.contains(tt.to_unixtime(day, stop_time.as_duration())));
       }
     }
@@ -10,7 +10,6 @@
 #include "utl/zip.h"
 
 #include "nigiri/common/day_list.h"
-#include "nigiri/common/linear_lower_bound.h"
 #include "nigiri/constants.h"
 #include "nigiri/timetable.h"
 
@@ -297,9 +296,7 @@ void preprocess_transport(timetable const& tt,
 
     // find first departure at or after a
     // departure time of current transport_to
-    auto earliest_dep =
-        linear_lb(event_times.begin(), event_times.end(), fp_arr_mam,
-                  [&](auto&& x, auto&& y) { return x.mam_ < y; });
+    auto earliest_dep = event_times.lower_bound_mam(fp_arr_mam);
 
     // no departure on this day at or after a
     auto transfer_day_offset = static_cast<std::int8_t>(fp_arr / 1440);
@@ -439,8 +436,10 @@ void preprocess_transport(timetable const& tt,
                     t_arr + tt.locations_.transfer_time_[from_stop].count(),
                     traffic_days);
     for (auto const& fp : tt.locations_.footpaths_out_[prf_idx][from_stop]) {
-      s.rr_arr_.update(fp.target(), t_arr + fp.duration_, traffic_days);
-      s.rr_ch_.update(fp.target(), t_arr + fp.duration_, traffic_days);
+      auto const fp_arr =
+          static_cast<std::uint16_t>(t_arr + fp.duration().count());
+      s.rr_arr_.update(fp.target(), fp_arr, traffic_days);
+      s.rr_ch_.update(fp.target(), fp_arr, traffic_days);
     }
 
     // iterate transfers found by line-based pruning
@@ -472,7 +471,7 @@ void preprocess_transport(timetable const& tt,
         for (auto const& fp_r :
              tt.locations_.footpaths_out_[profile_idx_t{0U}][u_stp]) {
           auto const eta = static_cast<std::uint16_t>(u_arr_rel_t_first_dep +
-                                                      fp_r.duration_);
+                                                      fp_r.duration().count());
           s.rr_arr_.update(fp_r.target(), eta, transfer->bf_, &improvement);
           s.rr_ch_.update(fp_r.target(), eta, transfer->bf_, &improvement);
         }
@@ -526,11 +525,8 @@ tb_data preprocess(timetable const& tt, profile_idx_t const prf_idx) {
   // Bitfield deduplication
   auto bitfields = hash_map<bitfield, tb_bitfield_idx_t>{};
   auto const get_or_create_bf = [&](bitfield const& bf) {
-    return utl::get_or_create(bitfields, bf, [&]() {
-      auto const idx = tb_bitfield_idx_t{d.bitfields_.size()};
-      d.bitfields_.emplace_back(bf);
-      return idx;
-    });
+    return utl::get_or_create(bitfields, bf,
+                              [&]() { return d.bitfields_.add(bf); });
   };
 
   // Allocate space.
@@ -8,6 +8,7 @@
 #include "utl/raii.h"
 
 #include "nigiri/for_each_meta.h"
+#include "nigiri/get_otel_tracer.h"
 #include "nigiri/routing/get_earliest_transport.h"
 #include "nigiri/routing/journey.h"
 #include "nigiri/routing/raptor/reconstruct.h"
@@ -99,6 +100,9 @@ void query_engine<UseLowerBounds>::execute(unixtime_t const start_time,
                                            unixtime_t const worst_time_at_dest,
                                            profile_idx_t const,
                                            pareto_set<journey>& results) {
+  auto span = get_otel_tracer()->StartSpan("tb::query_engine::execute");
+  auto scope = opentelemetry::trace::Scope{span};
+
   tb_queue_dbg("--- EXECUTE START_TIME={}", start_time);
 
   for (auto k = 0U; k != kMaxTransfers; ++k) {
@@ -140,6 +144,12 @@ void query_engine<UseLowerBounds>::execute(unixtime_t const start_time,
   stats_.n_segments_enqueued_ += state_.q_n_.size();
   stats_.n_rounds_ = k - 1U;
   stats_.max_transfers_reached_ = k == max_transfers;
+
+  span->SetAttribute("nigiri.tb.start_time",
+                     start_time.time_since_epoch().count());
+  span->SetAttribute("nigiri.tb.n_rounds", static_cast<std::uint32_t>(k));
+  span->SetAttribute("nigiri.tb.n_segments_enqueued", state_.q_n_.size());
+  span->SetAttribute("nigiri.tb.n_results", results.size());
 }
 
 template <bool UseLowerBounds>
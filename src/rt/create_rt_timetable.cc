@@ -11,11 +11,12 @@ rt_timetable create_rt_timetable(timetable const& tt,
                                  date::sys_days const base_day) {
   auto rtt = rt_timetable{};
   rtt.transport_traffic_days_ = tt.transport_traffic_days_;
-  rtt.bitfields_ = tt.bitfields_;
+  rtt.bitfields_ = compress(tt.bitfields_);
   rtt.base_day_ = base_day;
   rtt.base_day_idx_ = tt.day_idx(rtt.base_day_);
   // resize for later memory accesses
   rtt.location_rt_transports_[location_idx_t{tt.n_locations() - 1U}];
+  rtt.location_rt_routes_[location_idx_t{tt.n_locations() - 1U}];
   rtt.alerts_.route_type_.resize(tt.n_sources());
   rtt.alerts_.route_id_.resize(tt.n_sources());
   for (auto const [src, r] : utl::enumerate(tt.route_ids_)) {
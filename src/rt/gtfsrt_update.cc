@@ -1,5 +1,6 @@
 #include "nigiri/rt/gtfsrt_update.h"
 
+#include <chrono>
 #include <string_view>
 #include <vector>
 
@@ -12,6 +13,7 @@
 #include "nigiri/loader/gtfs/stop_seq_number_encoding.h"
 #include "nigiri/get_otel_tracer.h"
 #include "nigiri/logging.h"
+#include "nigiri/otel_metrics.h"
 #include "nigiri/lookup/get_transport.h"
 #include "nigiri/rt/frun.h"
 #include "nigiri/rt/gtfsrt_alert.h"
@@ -481,6 +483,9 @@ bool update_run(source_idx_t const src,
   if (n_not_cancelled_stops <= 1U) {
     rtt.cancel_run(r);
   }
+
+  // Stops and times were modified in place.
+  rtt.update_rt_route(r.rt_);
   return true;
 }
 
@@ -608,6 +613,7 @@ statistics gtfsrt_update_msg(timetable const& tt,
                              bool const use_vehicle_position) {
   auto span = get_otel_tracer()->StartSpan("gtfsrt_update_msg", {{"tag", tag}});
   auto scope = opentelemetry::trace::Scope{span};
+  auto const update_start = std::chrono::steady_clock::now();
 
   if (!msg.has_header()) {
     span->SetStatus(opentelemetry::trace::StatusCode::kError, "missing header");
@@ -806,6 +812,21 @@ statistics gtfsrt_update_msg(timetable const& tt,
     }
   }
 
+  auto const lag = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now() - message_time);
+  span->SetAttribute("nigiri.gtfsrt.lag_s", lag.count());
+  span->SetAttribute("nigiri.gtfsrt.total_entities_success",
+                     stats.total_entities_success_);
+  span->SetAttribute("nigiri.gtfsrt.total_entities_fail",
+                     stats.total_entities_fail_);
+  span->SetAttribute("nigiri.gtfsrt.trip_resolve_error",
+                     stats.trip_resolve_error_);
+  record_rt_update_metrics(
+      "gtfsrt", tag,
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - update_start),
+      lag);
+
   return stats;
 }
 
@@ -1,5 +1,7 @@
 #include "nigiri/rt/rt_timetable.h"
 
+#include <algorithm>
+
 #include "utl/enumerate.h"
 #include "utl/overloaded.h"
 #include "utl/timer.h"
@@ -8,6 +10,196 @@
 
 namespace nigiri {
 
+namespace {
+
+cista::hash_t rt_route_key_hash(rt_timetable const& rtt,
+                                rt_transport_idx_t const t) {
+  auto h = cista::BASE_HASH;
+  for (auto const s : rtt.rt_transport_location_seq_[t]) {
+    h = cista::hash_combine(h, s);
+  }
+  for (auto const c : rtt.rt_transport_section_clasz_[t]) {
+    h = cista::hash_combine(h, static_cast<std::uint8_t>(c));
+  }
+  h = cista::hash_combine(h, rtt.rt_transport_bikes_allowed_[to_idx(t) * 2U],
+                          rtt.rt_transport_bikes_allowed_[to_idx(t) * 2U + 1U],
+                          rtt.rt_transport_cars_allowed_[to_idx(t) * 2U],
+                          rtt.rt_transport_cars_allowed_[to_idx(t) * 2U + 1U]);
+  return h;
+}
+
+bool has_same_rt_route_key(rt_timetable const& rtt,
+                           rt_transport_idx_t const a,
+                           rt_transport_idx_t const b) {
+  auto const bit_eq = [&](bitvec const& bv, std::uint32_t const offset) {
+    return bv[to_idx(a) * 2U + offset] == bv[to_idx(b) * 2U + offset];
+  };
+  auto const span_eq = [](auto const& x, auto const& y) {
+    return std::equal(x.begin(), x.end(), y.begin(), y.end());
+  };
+  return span_eq(rtt.rt_transport_location_seq_[a],
+                 rtt.rt_transport_location_seq_[b]) &&
+         span_eq(rtt.rt_transport_section_clasz_[a],
+                 rtt.rt_transport_section_clasz_[b]) &&
+         bit_eq(rtt.rt_transport_bikes_allowed_, 0U) &&
+         bit_eq(rtt.rt_transport_bikes_allowed_, 1U) &&
+         bit_eq(rtt.rt_transport_cars_allowed_, 0U) &&
+         bit_eq(rtt.rt_transport_cars_allowed_, 1U) &&
+         span_eq(rtt.rt_bikes_allowed_per_section_[a],
+                 rtt.rt_bikes_allowed_per_section_[b]) &&
+         span_eq(rtt.rt_cars_allowed_per_section_[a],
+                 rtt.rt_cars_allowed_per_section_[b]);
+}
+
+// a does not overtake b: no event of a is later than the same event of b.
+bool is_fifo(rt_timetable const& rtt,
+             rt_transport_idx_t const a,
+             rt_transport_idx_t const b) {
+  auto const a_times = rtt.rt_transport_stop_times_[a];
+  auto const b_times = rtt.rt_transport_stop_times_[b];
+  for (auto i = 0U; i != a_times.size(); ++i) {
+    if (a_times[i] > b_times[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+delta_t first_time(rt_timetable const& rtt, rt_transport_idx_t const t) {
+  auto const times = rtt.rt_transport_stop_times_[t];
+  return times.empty() ? delta_t{0} : times[0];
+}
+
+template <typename Bucket>
+std::size_t rt_route_position(rt_timetable const& rtt,
+                              Bucket const& transports,
+                              rt_transport_idx_t const t) {
+  auto const time = first_time(rtt, t);
+  auto it = std::lower_bound(
+      transports.begin(), transports.end(), time,
+      [&](rt_transport_idx_t const x, delta_t const v) {
+        return first_time(rtt, x) < v;
+      });
+  for (; it != transports.end() && first_time(rtt, *it) == time; ++it) {
+    if (*it == t) {
+      return static_cast<std::size_t>(std::distance(transports.begin(), it));
+    }
+  }
+  // Only happens if the first event of t was changed.
+  return static_cast<std::size_t>(std::distance(
+      transports.begin(), std::find(transports.begin(), transports.end(), t)));
+}
+
+void add_to_rt_route(rt_timetable& rtt, rt_transport_idx_t const t) {
+  auto const location_seq = rtt.rt_transport_location_seq_[t];
+  auto& routes = rtt.rt_routes_by_key_[rt_route_key_hash(rtt, t)];
+  for (auto const r : routes) {
+    auto transports = rtt.rt_route_transports_[r];
+    if (transports.empty()
+            ? !std::equal(location_seq.begin(), location_seq.end(),
+                          rtt.rt_route_location_seq_[r].begin(),
+                          rtt.rt_route_location_seq_[r].end())
+            : !has_same_rt_route_key(rtt, transports[0], t)) {
+      continue;
+    }
+
+    auto const it = std::upper_bound(
+        transports.begin(), transports.end(), first_time(rtt, t),
+        [&](delta_t const v, rt_transport_idx_t const x) {
+          return v < first_time(rtt, x);
+        });
+    if ((it != transports.begin() && !is_fifo(rtt, *std::prev(it), t)) ||
+        (it != transports.end() && !is_fifo(rtt, t, *it))) {
+      continue;
+    }
+
+    transports.insert(it, t);
+    rtt.rt_transport_route_[t] = r;
+    return;
+  }
+
+  auto const r = rt_route_idx_t{rtt.rt_route_location_seq_.size()};
+  rtt.rt_route_location_seq_.emplace_back(location_seq);
+  rtt.rt_route_transports_[r].push_back(t);
+  rtt.rt_transport_route_[t] = r;
+  routes.push_back(r);
+  for (auto const s : location_seq) {
+    auto rt_routes = rtt.location_rt_routes_[stop{s}.location_idx()];
+    if (rt_routes.empty() || rt_routes.back() != r) {
+      rt_routes.push_back(r);
+    }
+  }
+}
+
+void remove_from_rt_route(rt_timetable& rtt, rt_transport_idx_t const t) {
+  auto const r = rtt.rt_transport_route_[t];
+  if (r == rt_route_idx_t::invalid()) {
+    return;
+  }
+  auto transports = rtt.rt_route_transports_[r];
+  transports.erase(std::next(
+      transports.begin(),
+      static_cast<std::ptrdiff_t>(rt_route_position(rtt, transports, t))));
+  rtt.rt_transport_route_[t] = rt_route_idx_t::invalid();
+}
+
+// t still fits its RT route: same stop sequence (incl. cancellations) and
+// grouping attributes as the other transports, sorted by the first departure
+// and no overtaking of its neighbours.
+bool fits_rt_route(rt_timetable const& rtt, rt_transport_idx_t const t) {
+  auto const r = rtt.rt_transport_route_[t];
+  if (r == rt_route_idx_t::invalid()) {
+    return false;
+  }
+
+  auto const location_seq = rtt.rt_transport_location_seq_[t];
+  auto const route_seq = rtt.rt_route_location_seq_[r];
+  if (!std::equal(location_seq.begin(), location_seq.end(), route_seq.begin(),
+                  route_seq.end())) {
+    return false;
+  }
+
+  auto const transports = rtt.rt_route_transports_[r];
+  auto const pos = rt_route_position(rtt, transports, t);
+  if (transports.size() > 1U &&
+      !has_same_rt_route_key(rtt, transports[pos == 0U ? 1U : 0U], t)) {
+    return false;
+  }
+
+  auto const fits_before = [&](rt_transport_idx_t const a,
+                               rt_transport_idx_t const b) {
+    return first_time(rtt, a) <= first_time(rtt, b) && is_fifo(rtt, a, b);
+  };
+  return (pos == 0U || fits_before(transports[pos - 1U], t)) &&
+         (pos + 1U == transports.size() ||
+          fits_before(t, transports[pos + 1U]));
+}
+
+}  // namespace
+
+bool rt_timetable::is_rt_route_order_valid(rt_transport_idx_t const rt_t,
+                                           std::size_t const ev_idx) const {
+  auto const r = rt_transport_route_[rt_t];
+  if (r == rt_route_idx_t::invalid()) {
+    return true;
+  }
+  auto const transports = rt_route_transports_.at(r);
+  auto const pos = rt_route_position(*this, transports, rt_t);
+  auto const time = rt_transport_stop_times_[rt_t][ev_idx];
+  return (pos == 0U ||
+          rt_transport_stop_times_[transports[pos - 1U]][ev_idx] <= time) &&
+         (pos + 1U == transports.size() ||
+          time <= rt_transport_stop_times_[transports[pos + 1U]][ev_idx]);
+}
+
+void rt_timetable::update_rt_route(rt_transport_idx_t const rt_t) {
+  if (fits_rt_route(*this, rt_t)) {
+    return;
+  }
+  remove_from_rt_route(*this, rt_t);
+  add_to_rt_route(*this, rt_t);
+}
+
 rt_transport_idx_t rt_timetable::add_rt_transport(
     source_idx_t const src,
     timetable const& tt,
@@ -27,9 +219,8 @@ rt_transport_idx_t rt_timetable::add_rt_transport(
     static_trip_lookup_.emplace(t, rt_t_idx);
     rt_transport_static_transport_.emplace_back(t);
 
-    auto const static_bf = bitfields_[transport_traffic_days_[t_idx]];
-    bitfields_.emplace_back(static_bf).set(to_idx(day), false);
-    transport_traffic_days_[t_idx] = bitfield_idx_t{bitfields_.size() - 1U};
+    transport_traffic_days_[t_idx] =
+        bitfields_.add_without(transport_traffic_days_[t_idx], to_idx(day));
   } else {
     auto const rt_add_idx =
         rt_add_trip_id_idx_t{additional_trips_.at(src).transports_.size()};
@@ -148,6 +339,9 @@ rt_transport_idx_t rt_timetable::add_rt_transport(
   assert(rt_transport_line_.size() == rt_t_idx + 1U);
   assert(rt_bikes_allowed_per_section_.size() == rt_t_idx + 1U);
 
+  rt_transport_route_.emplace_back(rt_route_idx_t::invalid());
+  add_to_rt_route(*this, rt_t);
+
   return rt_transport_idx_t{rt_t_idx};
 }
 
@@ -230,8 +424,8 @@ void rt_timetable::update_lbs(
 
         if (it != end(lbs)) {
           // The same target did exist already. Update existing.
-          it->duration_ = static_cast<location_idx_t::value_t>(
-              std::min(footpath::kMaxDuration, travel_time).count());
+          *it = footpath{it->target(),
+                         std::min(footpath::kMaxDuration, travel_time)};
         }
 
         // The same target did not exist yet. Push new.
@@ -278,10 +472,8 @@ void rt_timetable::cancel_run(rt::run const& r) {
     rt_transport_is_cancelled_.set(to_idx(r.rt_), true);
   }
   if (r.is_scheduled()) {
-    auto const bf = bitfields_[transport_traffic_days_[r.t_.t_idx_]];
-    bitfields_.emplace_back(bf).set(to_idx(r.t_.day_), false);
-    transport_traffic_days_[r.t_.t_idx_] =
-        bitfield_idx_t{bitfields_.size() - 1U};
+    transport_traffic_days_[r.t_.t_idx_] = bitfields_.add_without(
+        transport_traffic_days_[r.t_.t_idx_], to_idx(r.t_.day_));
 
     for (auto i = r.stop_range_.from_; i != r.stop_range_.to_; ++i) {
       dispatch_stop_change(r, i, event_type::kArr, std::nullopt, false);
@@ -1,22 +1,38 @@
 #include "nigiri/rt/vdv_aus.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <optional>
 #include <string>
 #include <string_view>
 
+#include "boost/json.hpp"
+
 #include "pugixml.hpp"
 
+#include "cista/hash.h"
+#include "cista/mmap.h"
+#include "cista/serialization.h"
+#include "cista/targets/file.h"
+
 #include "utl/enumerate.h"
 #include "utl/parser/arg_parser.h"
+#include "utl/verify.h"
 
 #include "fmt/core.h"
 
 #include "nigiri/common/interval.h"
 #include "nigiri/common/mam_dist.h"
+#include "nigiri/common/parallel_for.h"
 #include "nigiri/common/parse_time.h"
 #include "nigiri/for_each_meta.h"
+#include "nigiri/get_otel_tracer.h"
+#include "nigiri/logging.h"
+#include "nigiri/otel_metrics.h"
 #include "nigiri/rt/frun.h"
 #include "nigiri/rt/gtfsrt_resolve_run.h"
+#include "nigiri/rt/json_to_xml.h"
 #include "nigiri/rt/rt_timetable.h"
 #include "nigiri/rt/run.h"
 #include "nigiri/timetable.h"
@@ -40,6 +56,7 @@ constexpr auto const kAllowedTimeDiscrepancy = []() {
 }();  // minutes
 constexpr auto const kCleanUpInterval = 1h;
 constexpr auto const kMatchRetention = 8h;
+constexpr auto const kMinParallelMatches = 64U;
 
 // #define VDV_DEBUG
 #ifdef VDV_DEBUG
@@ -113,6 +130,79 @@ std::optional<unixtime_t> get_opt_time_siri(pugi::xml_node const& node,
   return get_opt_time(node, str, "%FT%T%Ez", "%FT%TZ");
 }
 
+// SIRI-JSON: scalars are either given directly or wrapped as {"value": x},
+// repeated elements are arrays (the first element is used for scalars).
+boost::json::value const* json_scalar(boost::json::object const& o,
+                                      std::string_view key) {
+  auto v = o.if_contains(key);
+  if (v != nullptr && v->is_array()) {
+    v = v->get_array().empty() ? nullptr : &v->get_array().front();
+  }
+  if (v != nullptr && v->is_object()) {
+    v = v->get_object().if_contains("value");
+  }
+  return v;
+}
+
+std::string_view json_val(boost::json::object const& o, std::string_view key) {
+  auto const v = json_scalar(o, key);
+  return v != nullptr && v->is_string() ? std::string_view{v->get_string()}
+                                        : std::string_view{};
+}
+
+std::optional<bool> get_opt_bool(
+    boost::json::object const& o,
+    char const* key,
+    std::optional<bool> default_to = std::nullopt) {
+  auto const v = json_scalar(o, key);
+  if (v != nullptr && v->is_bool()) {
+    return v->get_bool();
+  } else if (v != nullptr && v->is_string() && !v->get_string().empty()) {
+    return utl::parse<bool>(std::string_view{v->get_string()});
+  }
+  return default_to;
+}
+
+std::optional<std::string_view> get_opt_str(
+    boost::json::object const& o,
+    char const* key,
+    std::optional<std::string_view> default_to = std::nullopt) {
+  auto const v = json_val(o, key);
+  return v.empty() ? default_to : std::optional{v};
+}
+
+std::optional<unixtime_t> get_opt_time_siri(boost::json::object const& o,
+                                            char const* key) {
+  return get_opt_str(o, key).and_then(
+      [&](std::string_view value) -> std::optional<unixtime_t> {
+        try {
+          return std::optional{parse_time(value, "%FT%T%Ez", "%FT%TZ")};
+        } catch (std::exception const& e) {
+          log(log_lvl::error, "vdv_update.get_opt_time",
+              "invalid time input {:?} in {:?}: {}", key, value, e.what());
+          return std::nullopt;
+        }
+      });
+}
+
+template <typename Fn>
+void for_each_object(boost::json::object const& o,
+                     std::string_view key,
+                     Fn&& fn) {
+  auto const v = o.if_contains(key);
+  if (v == nullptr) {
+    return;
+  } else if (v->is_object()) {
+    fn(v->get_object());
+  } else if (v->is_array()) {
+    for (auto const& x : v->get_array()) {
+      if (x.is_object()) {
+        fn(x.get_object());
+      }
+    }
+  }
+}
+
 std::ostream& operator<<(std::ostream& out, statistics const& s) {
   out << "found runs: " << s.found_runs_ << " / " << s.total_runs_ << " ("
       << (100.0 * static_cast<double>(s.found_runs_) / s.total_runs_) << "%)\n"
@@ -136,10 +226,31 @@ std::ostream& operator<<(std::ostream& out, statistics const& s) {
       << "\nskipped vdv stops: " << s.skipped_vdv_stops_
       << "\nexcess vdv stops: " << s.excess_vdv_stops_
       << "\nupdated events: " << s.updated_events_
-      << "\npropagated delays: " << s.propagated_delays_ << "\n";
+      << "\npropagated delays: " << s.propagated_delays_
+      << "\nmatch cache hits: " << s.match_cache_hits_ << " ("
+      << (100.0 * s.match_cache_hit_rate()) << "%)"
+      << "\nrestored matches: " << s.restored_matches_
+      << "\nrestored match hits: " << s.restored_match_hits_
+      << "\nparse time: " << s.parse_time_.count() << "us"
+      << "\nmatch time: " << s.match_time_.count() << "us"
+      << "\ntime saved by restored matches: "
+      << s.restored_time_saved().count() << "us\n";
   return out;
 }
 
+double statistics::match_cache_hit_rate() const {
+  auto const total = match_cache_hits_ + match_attempts_;
+  return total == 0U ? 0.0
+                     : static_cast<double>(match_cache_hits_) /
+                           static_cast<double>(total);
+}
+
+std::chrono::microseconds statistics::restored_time_saved() const {
+  return match_attempts_ == 0U
+             ? std::chrono::microseconds{0}
+             : match_time_ * restored_match_hits_ / match_attempts_;
+}
+
 statistics& statistics::operator+=(statistics const& o) {
   auto const x = cista::to_tuple(*this);
   auto const y = cista::to_tuple(o);
@@ -151,13 +262,69 @@ statistics& statistics::operator+=(statistics const& o) {
   [&]<std::size_t... I>(std::index_sequence<I...>) {
     ((add(std::get<I>(x), std::get<I>(y))), ...);
   }(std::make_index_sequence<std::tuple_size_v<decltype(x)>>());
+  parse_time_ += o.parse_time_;
+  match_time_ += o.match_time_;
   return *this;
 }
 
+std::map<std::string, std::uint64_t> statistics::to_map() const {
+  return {
+      {"total_runs", total_runs_},
+      {"unique_runs", unique_runs_},
+      {"matched_runs", matched_runs_},
+      {"found_runs", found_runs_},
+      {"multiple_matches", multiple_matches_},
+      {"match_cache_hits", match_cache_hits_},
+      {"cancelled_runs", cancelled_runs_},
+      {"total_stops", total_stops_},
+      {"resolved_stops", resolved_stops_},
+      {"updated_events", updated_events_},
+      {"propagated_delays", propagated_delays_},
+      {"unsupported_additional_runs", unsupported_additional_runs_},
+      {"parse_time_us", static_cast<std::uint64_t>(parse_time_.count())},
+      {"match_time_us", static_cast<std::uint64_t>(match_time_.count())},
+  };
+}
+
+namespace {
+
+void finish_update_span(opentelemetry::trace::Span& span,
+                        statistics const& stats,
+                        updater::xml_format const format,
+                        std::chrono::steady_clock::time_point const start) {
+  constexpr auto const kFormatNames =
+      std::array<std::string_view, 3U>{"vdv", "siri", "siri_json"};
+  set_span_attributes(span, "nigiri.vdv_aus.", stats.to_map());
+  record_rt_update_metrics(
+      "vdv_aus", kFormatNames[static_cast<std::size_t>(format)],
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start),
+      std::nullopt);
+}
+
+}  // namespace
+
 updater::updater(nigiri::timetable const& tt,
                  source_idx_t const src_idx,
                  xml_format const format)
-    : tt_{tt}, src_idx_{src_idx}, format_{format} {}
+    : tt_{tt}, src_idx_{src_idx}, format_{format} {
+  auto route_stops = std::vector<route_stop>{};
+  for (auto l = location_idx_t{0U}; l != tt_.n_locations(); ++l) {
+    route_stops.clear();
+    if (to_idx(l) < tt_.location_routes_.size()) {
+      for (auto const r : tt_.location_routes_[l]) {
+        for (auto const [stop_idx, s] :
+             utl::enumerate(tt_.route_location_seq_[r])) {
+          if (stop{s}.location_idx() == l) {
+            route_stops.push_back(
+                route_stop{r, static_cast<stop_idx_t>(stop_idx)});
+          }
+        }
+      }
+    }
+    location_route_stops_.emplace_back(route_stops);
+  }
+}
 
 void updater::reset_vdv_run_ids_() { matches_.clear(); }
 
@@ -168,6 +335,10 @@ statistics const& updater::get_cumulative_stats() const {
 source_idx_t updater::get_src() const { return src_idx_; }
 updater::xml_format updater::get_format() const { return format_; }
 
+void updater::set_parallel_for(parallel_for_fn executor) {
+  parallel_for_ = std::move(executor);
+}
+
 bool is_vdv(updater::xml_format const f) {
   return f == updater::xml_format::kVdv;
 }
@@ -208,6 +379,27 @@ updater::vdv_stop::vdv_stop(location_idx_t const l,
       dep_canceled_{is_vdv(f) ? *get_opt_bool(n, "AbfahrtFaelltAus", false)
                               : arr_canceled_} {}
 
+updater::vdv_stop::vdv_stop(location_idx_t const l,
+                            std::string_view id,
+                            boost::json::object const& o)
+    : l_{l},
+      id_{id},
+      dep_{get_opt_time_siri(o, "aimedDepartureTime")},
+      arr_{get_opt_time_siri(o, "aimedArrivalTime")},
+      rt_dep_{get_opt_time_siri(o, "expectedDepartureTime").or_else([&]() {
+        return get_opt_time_siri(o, "actualDepartureTime");
+      })},
+      rt_arr_{get_opt_time_siri(o, "expectedArrivalTime").or_else([&]() {
+        return get_opt_time_siri(o, "actualArrivalTime");
+      })},
+      in_forbidden_{*get_opt_str(o, "departureBoardingActivity", "boarding") !=
+                    "boarding"},
+      out_forbidden_{*get_opt_str(o, "arrivalBoardingActivity", "alighting") !=
+                     "alighting"},
+      passing_through_{in_forbidden_ && out_forbidden_},
+      arr_canceled_{*get_opt_bool(o, "cancellation", false)},
+      dep_canceled_{arr_canceled_} {}
+
 std::optional<std::pair<unixtime_t, event_type>> updater::vdv_stop::get_event(
     std::optional<event_type> const et) const {
   if ((!et || et == event_type::kDep) && dep_) {
@@ -219,44 +411,53 @@ std::optional<std::pair<unixtime_t, event_type>> updater::vdv_stop::get_event(
   }
 }
 
+location_idx_t updater::resolve_stop(std::string_view const vdv_stop_id,
+                                    bool const is_additional_stop,
+                                    statistics& stats) const {
+  ++stats.total_stops_;
+
+  auto const l = [&]() {
+    auto const x = tt_.find(location_id{vdv_stop_id, src_idx_});
+    if (x.has_value()) {
+      return x;
+    } else if (auto const underscore_pos = vdv_stop_id.find('_');
+               underscore_pos != std::string_view::npos) {
+      // Extra matching code for VRR SIRI. Remove after data is fixed.
+      return tt_.find(
+          location_id{vdv_stop_id.substr(0, underscore_pos + 1U), src_idx_});
+    } else {
+      return x;
+    }
+  }();
+
+  if (is_additional_stop) {
+    ++stats.unsupported_additional_stops_;
+    vdv_trace("unsupported additional stop: [id: {}, name: {}]\n",
+              vdv_stop_id, loc{tt_, l.value_or(location_idx_t::invalid())});
+  }
+
+  if (l.has_value()) {
+    ++stats.resolved_stops_;
+    return *l;
+  } else {
+    vdv_trace("unresolvable stop: {}\n", vdv_stop_id);
+    return location_idx_t::invalid();
+  }
+}
+
 vector<updater::vdv_stop> updater::resolve_stops(pugi::xml_node const vdv_run,
                                                  statistics& stats) {
   auto vdv_stops = vector<vdv_stop>{};
 
   auto const add_stop = [&](pugi::xml_node const stop) {
-    ++stats.total_stops_;
-
     auto const vdv_stop_id = std::string_view{
         stop.child_value(is_vdv(format_) ? "HaltID" : "StopPointRef")};
-    auto const l = [&]() {
-      auto const x = tt_.find(location_id{vdv_stop_id, src_idx_});
-      if (x.has_value()) {
-        return x;
-      } else if (auto const underscore_pos = vdv_stop_id.find('_');
-                 underscore_pos != std::string_view::npos) {
-        // Extra matching code for VRR SIRI. Remove after data is fixed.
-        return tt_.find(
-            location_id{vdv_stop_id.substr(0, underscore_pos + 1U), src_idx_});
-      } else {
-        return x;
-      }
-    }();
-
-    if (get_opt_bool(stop, is_vdv(format_) ? "Zusatzhalt" : "ExtraCall", false)
-            .value()) {
-      ++stats.unsupported_additional_stops_;
-      vdv_trace("unsupported additional stop: [id: {}, name: {}]\n",
-                vdv_stop_id, loc{tt_, l.value_or(location_idx_t::invalid())});
-    }
-
-    if (l.has_value()) {
-      ++stats.resolved_stops_;
-      vdv_stops.emplace_back(*l, vdv_stop_id, stop, format_);
-    } else {
-      vdv_stops.emplace_back(location_idx_t::invalid(), vdv_stop_id, stop,
-                             format_);
-      vdv_trace("unresolvable stop: {}\n", vdv_stop_id);
-    }
+    auto const l = resolve_stop(
+        vdv_stop_id,
+        get_opt_bool(stop, is_vdv(format_) ? "Zusatzhalt" : "ExtraCall", false)
+            .value(),
+        stats);
+    vdv_stops.emplace_back(l, vdv_stop_id, stop, format_);
   };
 
   if (is_vdv(format_)) {
@@ -276,6 +477,27 @@ vector<updater::vdv_stop> updater::resolve_stops(pugi::xml_node const vdv_run,
   return vdv_stops;
 }
 
+vector<updater::vdv_stop> updater::resolve_stops(
+    boost::json::object const& vdv_run, statistics& stats) {
+  auto vdv_stops = vector<vdv_stop>{};
+
+  auto const add_stop = [&](boost::json::object const& stop) {
+    auto const vdv_stop_id = json_val(stop, "stopPointRef");
+    auto const l = resolve_stop(
+        vdv_stop_id, get_opt_bool(stop, "extraCall", false).value(), stats);
+    vdv_stops.emplace_back(l, vdv_stop_id, stop);
+  };
+
+  for_each_object(vdv_run, "recordedCalls", [&](auto const& calls) {
+    for_each_object(calls, "recordedCall", add_stop);
+  });
+  for_each_object(vdv_run, "estimatedCalls", [&](auto const& calls) {
+    for_each_object(calls, "estimatedCall", add_stop);
+  });
+
+  return vdv_stops;
+}
+
 struct candidate {
   explicit candidate(run const& r, std::uint32_t const total_length)
       : r_{r}, total_length_{total_length} {}
@@ -300,16 +522,20 @@ struct candidate {
   std::uint32_t total_length_;
 };
 
-void updater::match_run(run_id const& vdv_id,
-                        vector<vdv_stop> const& vdv_stops,
-                        statistics& stats,
-                        bool const is_complete_run) {
+updater::match_result updater::match_run(run_id const& vdv_id,
+                                         vector<vdv_stop> const& vdv_stops,
+                                         bool const is_complete_run) const {
+  auto const start = std::chrono::steady_clock::now();
+  auto result = match_result{};
+  auto& stats = result.stats_;
   ++stats.match_attempts_;
+  auto const finish = [&]() {
+    stats.match_time_ = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    return std::move(result);
+  };
 
-  auto const& vdv_run_id = vdv_id.full_;
-
-  matches_[vdv_run_id] = match{};
-  auto candidates = std::vector<candidate>{};
+  [[maybe_unused]] auto const& vdv_run_id = vdv_id.full_;
 
   if (!vdv_id.run_.empty() && vdv_id.date_.has_value()) {
     auto td = transit_realtime::TripDescriptor{};
@@ -319,78 +545,92 @@ void updater::match_run(run_id const& vdv_id,
     auto const [r, _] =
         gtfsrt_resolve_run(date::sys_days{}, tt_, nullptr, src_idx_, td);
     if (r.valid()) {
-      matches_[vdv_run_id].runs_.emplace_back(r);
-      return;
+      result.runs_.emplace_back(r);
+      return finish();
     }
   }
 
+  auto candidates = std::vector<candidate>{};
+  auto candidate_idx = hash_map<transport, std::uint32_t>{};
   for (auto const& vdv_stop : vdv_stops) {
     if (vdv_stop.l_ == location_idx_t::invalid()) {
       continue;
     }
     auto no_transport_found_at_stop = true;
     for (auto const l : tt_.locations_.equivalences_[vdv_stop.l_]) {
-      for (auto const r : tt_.location_routes_[l]) {
-        auto const location_seq = tt_.route_location_seq_[r];
-        for (auto const [stop_idx, s] : utl::enumerate(location_seq)) {
-          if (stop{s}.location_idx() != l) {
-            continue;
+      for (auto const& rs : location_route_stops_[l]) {
+        auto const r = rs.r_;
+        auto const stop_idx = rs.stop_idx_;
+        auto const n_stops = tt_.route_location_seq_[r].size();
+        auto const vdv_ev = stop_idx == 0U ? vdv_stop.get_event(event_type::kDep)
+                            : stop_idx == n_stops - 1U
+                                ? vdv_stop.get_event(event_type::kArr)
+                                : vdv_stop.get_event();
+        if (!vdv_ev.has_value()) {
+          continue;
+        }
+
+        auto const ev_type = vdv_ev->second;
+        auto const vdv_day_idx = tt_.day_idx_mam(vdv_ev->first).first;
+        auto const vdv_mam = tt_.day_idx_mam(vdv_ev->first).second;
+
+        auto const add = [&](std::size_t const nigiri_ev_time_idx,
+                             delta const nigiri_ev_time) {
+          auto const [error, day_shift] =
+              mam_dist(vdv_mam, i32_minutes{nigiri_ev_time.mam()});
+          auto const local_score =
+              kExactMatchScore - error.count() * error.count();
+          if (local_score < 0) {
+            return;
           }
-          auto const vdv_ev = stop_idx == 0
-                                  ? vdv_stop.get_event(event_type::kDep)
-                              : stop_idx == location_seq.size() - 1
-                                  ? vdv_stop.get_event(event_type::kArr)
-                                  : vdv_stop.get_event();
-          if (!vdv_ev.has_value()) {
-            continue;
+
+          auto const tr = transport{
+              tt_.route_transport_ranges_[r][nigiri_ev_time_idx],
+              vdv_day_idx -
+                  day_idx_t{nigiri_ev_time.days() - day_shift.count()}};
+
+          if (!tt_.bitfields_[tt_.transport_traffic_days_[tr.t_idx_]].test(
+                  to_idx(tr.day_))) {
+            return;
           }
 
-          auto const [vdv_time, ev_type] = *vdv_ev;
-          auto const [vdv_day_idx, vdv_mam] = tt_.day_idx_mam(vdv_time);
-
-          for (auto const [nigiri_ev_time_idx, nigiri_ev_time] :
-               utl::enumerate(tt_.event_times_at_stop(
-                   r, static_cast<stop_idx_t>(stop_idx), ev_type))) {
-            auto const [error, day_shift] =
-                mam_dist(vdv_mam, i32_minutes{nigiri_ev_time.mam()});
-            auto const local_score =
-                kExactMatchScore - error.count() * error.count();
-            if (local_score < 0) {
-              continue;
-            }
-
-            auto const tr = transport{
-                tt_.route_transport_ranges_[r][nigiri_ev_time_idx],
-                vdv_day_idx -
-                    day_idx_t{nigiri_ev_time.days() - day_shift.count()}};
-
-            if (tt_.bitfields_[tt_.transport_traffic_days_[tr.t_idx_]].test(
-                    to_idx(tr.day_))) {
-              auto candidate =
-                  std::find_if(begin(candidates), end(candidates),
-                               [&](auto const& c) { return c.r_.t_ == tr; });
-
-              if (candidate != end(candidates) &&
-                  stop_idx < candidate->r_.stop_range_.from_) {
-                continue;
-              }
-
-              if (candidate == end(candidates)) {
-                candidates.emplace_back(
-                    run{tr,
-                        interval{static_cast<stop_idx_t>(stop_idx),
-                                 static_cast<stop_idx_t>(location_seq.size())}},
-                    location_seq.size());
-                candidate = end(candidates) - 1;
-              }
-
-              candidate->local_best_ =
-                  std::max(candidate->local_best_,
-                           static_cast<std::uint32_t>(local_score));
-
-              no_transport_found_at_stop = false;
-            }
+          auto const [it, inserted] = candidate_idx.emplace(
+              tr, static_cast<std::uint32_t>(candidates.size()));
+          if (inserted) {
+            candidates.emplace_back(
+                run{tr, interval{stop_idx, static_cast<stop_idx_t>(n_stops)}},
+                n_stops);
+          } else if (stop_idx < candidates[it->second].r_.stop_range_.from_) {
+            return;
           }
+
+          auto& c = candidates[it->second];
+          c.local_best_ =
+              std::max(c.local_best_, static_cast<std::uint32_t>(local_score));
+
+          no_transport_found_at_stop = false;
+        };
+
+        // Event times at a stop are sorted by minutes after midnight (no
+        // overtaking modulo one day, see get_index / partition_routes), not
+        // by their full delta: only visit the events within the allowed
+        // discrepancy around the time of day, wrapping around midnight.
+        auto const ev_times = tt_.event_times_at_stop(r, stop_idx, ev_type);
+        auto const visit = [&](int const from_mam, int const to_mam) {
+          for (auto it = ev_times.lower_bound_mam(from_mam);
+               it != end(ev_times) && it->mam() <= to_mam; ++it) {
+            add(route_event_times::index(it), *it);
+          }
+        };
+        auto const at = static_cast<int>(vdv_mam.count());
+        auto const from = at - kAllowedTimeDiscrepancy;
+        auto const to = at + kAllowedTimeDiscrepancy;
+        visit(std::max(from, 0), std::min(to, 1439));
+        if (from < 0) {
+          visit(from + 1440, 1439);
+        }
+        if (to > 1439) {
+          visit(0, to - 1440);
         }
       }
     }
@@ -416,7 +656,7 @@ void updater::match_run(run_id const& vdv_id,
     for (auto const& c : candidates) {
       if (is_match(c)) {
         vdv_trace("match_run(vdv_run_id={})\n", vdv_run_id);
-        matches_[vdv_run_id].runs_.emplace_back(c.r_);
+        result.runs_.emplace_back(c.r_);
       } else {
         break;
       }
@@ -429,12 +669,12 @@ void updater::match_run(run_id const& vdv_id,
                        c.total_length_, tt_.dbg(c.r_.t_.t_idx_));
   };
 
-  if (matches_[vdv_run_id].runs_.empty()) {
+  if (result.runs_.empty()) {
     vdv_trace("[vdv_aus] no match for {}, best candidate: {}\n", vdv_run_id,
               candidates.empty() ? "none" : candidate_str(candidates.front()));
   } else {
     ++stats.matched_runs_;
-    if (matches_[vdv_run_id].runs_.size() > 1) {
+    if (result.runs_.size() > 1) {
       ++stats.multiple_matches_;
       vdv_trace("[vdv_aus] multiple matches for {}:", vdv_run_id);
       for (auto const& c : candidates) {
@@ -446,6 +686,8 @@ void updater::match_run(run_id const& vdv_id,
       vdv_trace("\n");
     }
   }
+
+  return finish();
 }
 
 void update_event(rt_timetable& rtt,
@@ -624,6 +866,9 @@ void updater::update_run(rt_timetable& rtt,
   if (!fr.is_cancelled()) {
     monotonize(fr, rtt);
   }
+
+  // Stop changes are written in place.
+  rtt.update_rt_route(fr.rt_);
 }
 
 std::optional<updater::run_id> updater::resolve_run_id(
@@ -670,26 +915,38 @@ std::optional<updater::run_id> updater::resolve_run_id(
   }
 };
 
-void updater::process_vdv_run(rt_timetable& rtt,
-                              pugi::xml_node const vdv_run,
-                              statistics& stats) {
-  ++stats.total_runs_;
-  auto const is_complete_run = *get_opt_bool(
-      vdv_run,
-      format_ == xml_format::kVdv ? "Komplettfahrt" : "IsCompleteStopSequence",
-      false);
-  if (is_complete_run) {
-    ++stats.complete_runs_;
+std::optional<updater::run_id> updater::resolve_run_id(
+    boost::json::object const& vdv_run) {
+  if (auto const run = json_val(vdv_run, "datedVehicleJourneyRef");
+      !run.empty()) {
+    return run_id{
+        .full_ = std::string{run},
+        .run_ = run,
+    };
   }
 
-  auto vdv_stops = resolve_stops(vdv_run, stats);
-  auto id = resolve_run_id(vdv_run);
-  if (!id.has_value()) {
-    vdv_trace("vdv run without id: {}\n", vdv_run.value());
-    return;
+  auto const framed = vdv_run.if_contains("framedVehicleJourneyRef");
+  if (framed != nullptr && framed->is_object()) {
+    auto const run = json_val(framed->get_object(), "datedVehicleJourneyRef");
+    auto const day = json_val(framed->get_object(), "dataFrameRef");
+    return run_id{
+        .full_ = fmt::format("{}{}", run, day),
+        .run_ = run,
+        .date_ = day,
+    };
   }
 
-  auto const& vdv_run_id = id->full_;
+  return std::nullopt;
+}
+
+void updater::process_run(rt_timetable& rtt,
+                          parsed_run const& vdv_run,
+                          match_result* precomputed,
+                          statistics& stats) {
+  auto const& id = vdv_run.id_;
+  auto const& vdv_run_id = id.full_;
+  auto const& vdv_stops = vdv_run.stops_;
+  auto const is_complete_run = vdv_run.is_complete_;
 
   if (vdv_stops.empty()) {
     ++stats.runs_without_stops_;
@@ -697,14 +954,24 @@ void updater::process_vdv_run(rt_timetable& rtt,
     return;
   }
 
+  auto const apply_match = [&]() {
+    auto m = precomputed != nullptr
+                 ? std::move(*precomputed)
+                 : match_run(id, vdv_stops, is_complete_run);
+    stats += m.stats_;
+    auto& entry = matches_[vdv_run_id];
+    entry = match{};
+    entry.runs_ = std::move(m.runs_);
+  };
+
   auto const seen_before = matches_.contains(vdv_run_id);
   if (!seen_before) {
     ++stats.unique_runs_;
     if (is_complete_run) {
-      match_run(*id, vdv_stops, stats, is_complete_run);
+      apply_match();
     } else {
       ++stats.incomplete_not_seen_before_;
-      match_run(*id, vdv_stops, stats, is_complete_run);
+      apply_match();
       matches_[vdv_run_id].only_saw_incomplete_ = true;
     }
   }
@@ -712,15 +979,19 @@ void updater::process_vdv_run(rt_timetable& rtt,
   if (seen_before && is_complete_run &&
       matches_[vdv_run_id].only_saw_incomplete_) {
     ++stats.complete_after_incomplete_;
-    match_run(*id, vdv_stops, stats, is_complete_run);
+    apply_match();
     matches_[vdv_run_id].only_saw_incomplete_ = false;
+  } else if (seen_before) {
+    ++stats.match_cache_hits_;
+    if (auto& m = matches_[vdv_run_id]; m.restored_) {
+      ++stats.restored_match_hits_;
+      m.restored_ = false;
+    }
   }
 
   auto const& runs = matches_[vdv_run_id].runs_;
   for (auto& r : runs) {
-    auto const cancelled_run_selector =
-        format_ == xml_format::kVdv ? "FaelltAus" : "Cancellation";
-    if (get_opt_bool(vdv_run, cancelled_run_selector, false).value()) {
+    if (vdv_run.is_cancelled_) {
       rtt.cancel_run(r);
       ++stats.cancelled_runs_;
     } else {
@@ -735,6 +1006,106 @@ void updater::process_vdv_run(rt_timetable& rtt,
           std::chrono::system_clock::now());
 }
 
+void updater::process_runs(rt_timetable& rtt,
+                           std::vector<parsed_run> const& runs,
+                           statistics& stats) {
+  // Determine which runs process_run will match (first occurrence or first
+  // complete occurrence after only incomplete ones). Matching only reads the
+  // static timetable, so it can run on the executor set with
+  // set_parallel_for. Results are applied in order.
+  auto to_match = std::vector<std::size_t>{};
+  auto only_saw_incomplete = hash_map<std::string_view, bool>{};
+  for (auto const [i, r] : utl::enumerate(runs)) {
+    if (r.stops_.empty()) {
+      continue;
+    }
+
+    auto const& id = r.id_.full_;
+    auto const it = only_saw_incomplete.find(id);
+    auto const m = matches_.find(id);
+    auto const seen_before =
+        it != end(only_saw_incomplete) || m != end(matches_);
+    auto const incomplete =
+        it != end(only_saw_incomplete)
+            ? it->second
+            : m != end(matches_) && m->second.only_saw_incomplete_;
+    if (!seen_before || (r.is_complete_ && incomplete)) {
+      to_match.push_back(i);
+    }
+    only_saw_incomplete[id] =
+        seen_before ? incomplete && !r.is_complete_ : !r.is_complete_;
+  }
+
+  auto matched = std::vector<match_result>(to_match.size());
+  auto const match_one = [&](std::size_t const i) {
+    auto const& r = runs[to_match[i]];
+    matched[i] = match_run(r.id_, r.stops_, r.is_complete_);
+  };
+  parallel_for(to_match.size() < kMinParallelMatches ? parallel_for_fn{}
+                                                      : parallel_for_,
+               to_match.size(), match_one);
+
+  auto next = 0U;
+  for (auto const [i, r] : utl::enumerate(runs)) {
+    auto const precomputed = next != to_match.size() && to_match[next] == i
+                                 ? &matched[next++]
+                                 : nullptr;
+    process_run(rtt, r, precomputed, stats);
+  }
+}
+
+std::optional<updater::parsed_run> updater::parse_run(
+    pugi::xml_node const vdv_run, statistics& stats) {
+  ++stats.total_runs_;
+  auto const is_complete_run = *get_opt_bool(
+      vdv_run,
+      format_ == xml_format::kVdv ? "Komplettfahrt" : "IsCompleteStopSequence",
+      false);
+  if (is_complete_run) {
+    ++stats.complete_runs_;
+  }
+
+  auto vdv_stops = resolve_stops(vdv_run, stats);
+  auto id = resolve_run_id(vdv_run);
+  if (!id.has_value()) {
+    vdv_trace("vdv run without id: {}\n", vdv_run.value());
+    return std::nullopt;
+  }
+
+  auto const is_cancelled =
+      get_opt_bool(vdv_run,
+                   format_ == xml_format::kVdv ? "FaelltAus" : "Cancellation",
+                   false)
+          .value();
+  return parsed_run{.id_ = std::move(*id),
+                    .stops_ = std::move(vdv_stops),
+                    .is_complete_ = is_complete_run,
+                    .is_cancelled_ = is_cancelled};
+}
+
+std::optional<updater::parsed_run> updater::parse_run(
+    boost::json::object const& vdv_run, statistics& stats) {
+  ++stats.total_runs_;
+  auto const is_complete_run =
+      *get_opt_bool(vdv_run, "isCompleteStopSequence", false);
+  if (is_complete_run) {
+    ++stats.complete_runs_;
+  }
+
+  auto vdv_stops = resolve_stops(vdv_run, stats);
+  auto id = resolve_run_id(vdv_run);
+  if (!id.has_value()) {
+    vdv_trace("vdv run without id\n");
+    return std::nullopt;
+  }
+
+  return parsed_run{
+      .id_ = std::move(*id),
+      .stops_ = std::move(vdv_stops),
+      .is_complete_ = is_complete_run,
+      .is_cancelled_ = *get_opt_bool(vdv_run, "cancellation", false)};
+}
+
 void updater::affects_alerts(rt_timetable& rtt,
                              pugi::xml_node const affects,
                              alert_idx_t const alert) {
@@ -867,13 +1238,162 @@ void updater::clean_up() {
   last_cleanup = now;
 }
 
+namespace {
+
+constexpr auto const kSnapshotMode =
+    cista::mode::WITH_INTEGRITY | cista::mode::WITH_STATIC_VERSION;
+
+struct match_snapshot_entry {
+  string id_;
+  std::int64_t last_accessed_;
+  bool only_saw_incomplete_;
+  vector<run> runs_;
+};
+
+struct match_snapshot {
+  std::uint64_t tt_fingerprint_;
+  vector<match_snapshot_entry> entries_;
+};
+
+// Matches refer to transport and day indices of the static timetable.
+// Snapshots are only valid for the timetable (and source) they were taken on:
+// hashes the trip ids of the source with their transports as well as the
+// event times and traffic days of all transports.
+std::uint64_t tt_fingerprint(timetable const& tt, source_idx_t const src) {
+  auto const bytes = [](auto const& v) {
+    return std::string_view{reinterpret_cast<char const*>(v.data()),
+                            v.size() * sizeof(*v.data())};
+  };
+
+  auto h = cista::BASE_HASH;
+  for (auto const x : std::initializer_list<std::uint64_t>{
+           static_cast<std::uint64_t>(
+               tt.date_range_.from_.time_since_epoch().count()),
+           static_cast<std::uint64_t>(
+               tt.date_range_.to_.time_since_epoch().count()),
+           to_idx(src)}) {
+    h = cista::hash_combine(h, x);
+  }
+  h = cista::hash(bytes(tt.route_stop_times_), h);
+  h = cista::hash(bytes(tt.route_headways_.data_), h);
+  h = cista::hash(bytes(tt.transport_traffic_days_), h);
+  h = cista::hash(bytes(tt.bitfields_), h);
+  for (auto t = trip_idx_t{0U}; t != tt.trip_ids_.size(); ++t) {
+    for (auto const id : tt.trip_ids_[t]) {
+      if (tt.trip_id_src_[id] != src) {
+        continue;
+      }
+      h = cista::hash(tt.trip_id_strings_[id].view(), h);
+      for (auto const& [transport, stop_range] : tt.trip_transport_ranges_[t]) {
+        h = cista::hash_combine(h, to_idx(transport), stop_range.from_,
+                                stop_range.to_);
+      }
+    }
+  }
+  return h;
+}
+
+}  // namespace
+
+std::uint64_t updater::get_tt_fingerprint() const {
+  if (!tt_fingerprint_.has_value()) {
+    tt_fingerprint_ = tt_fingerprint(tt_, src_idx_);
+  }
+  return *tt_fingerprint_;
+}
+
+void updater::write_matches(std::filesystem::path const& p,
+                            std::size_t const max_entries) const {
+  auto const now = std::chrono::time_point_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now());
+
+  auto recent = std::vector<hash_map<std::string, match>::value_type const*>{};
+  for (auto const& entry : matches_) {
+    if (now - entry.second.last_accessed_ <= kMatchRetention) {
+      recent.push_back(&entry);
+    }
+  }
+  if (recent.size() > max_entries) {
+    std::nth_element(begin(recent), begin(recent) + max_entries, end(recent),
+                     [](auto const* a, auto const* b) {
+                       return a->second.last_accessed_ >
+                              b->second.last_accessed_;
+                     });
+    recent.resize(max_entries);
+  }
+
+  auto snapshot =
+      match_snapshot{.tt_fingerprint_ = get_tt_fingerprint()};
+  snapshot.entries_.reserve(recent.size());
+  for (auto const* entry : recent) {
+    auto const& [id, m] = *entry;
+    snapshot.entries_.push_back(match_snapshot_entry{
+        .id_ = string{std::string_view{id}},
+        .last_accessed_ = m.last_accessed_.time_since_epoch().count(),
+        .only_saw_incomplete_ = m.only_saw_incomplete_,
+        .runs_ = vector<run>{begin(m.runs_), end(m.runs_)}});
+  }
+
+  auto mmap = cista::mmap{p.generic_string().c_str(),
+                          cista::mmap::protection::WRITE};
+  auto writer = cista::buf<cista::mmap>(std::move(mmap));
+  cista::serialize<kSnapshotMode>(writer, snapshot);
+}
+
+std::size_t updater::read_matches(std::filesystem::path const& p) {
+  if (!std::filesystem::is_regular_file(p)) {
+    log(log_lvl::info, "vdv_aus.read_matches", "no match snapshot at {}",
+        p.generic_string());
+    return 0U;
+  }
+
+  auto buf = cista::file{p.generic_string().c_str(), "r"}.content();
+  auto const* snapshot = cista::deserialize<match_snapshot, kSnapshotMode>(buf);
+  if (snapshot->tt_fingerprint_ != get_tt_fingerprint()) {
+    log(log_lvl::info, "vdv_aus.read_matches",
+        "ignoring match snapshot {} of another timetable", p.generic_string());
+    return 0U;
+  }
+
+  auto const now = std::chrono::time_point_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now());
+  auto n_restored = std::uint32_t{0U};
+  for (auto const& e : snapshot->entries_) {
+    auto const last_accessed =
+        std::chrono::sys_seconds{std::chrono::seconds{e.last_accessed_}};
+    auto id = std::string{e.id_.view()};
+    if (now - last_accessed > kMatchRetention || matches_.contains(id)) {
+      continue;
+    }
+    auto& m = matches_[std::move(id)];
+    m.last_accessed_ = last_accessed;
+    m.only_saw_incomplete_ = e.only_saw_incomplete_;
+    m.restored_ = true;
+    m.runs_.assign(begin(e.runs_), end(e.runs_));
+    ++n_restored;
+  }
+
+  cumulative_stats_.restored_matches_ += n_restored;
+  cumulative_stats_.current_matches_total_ = matches_.size();
+  log(log_lvl::info, "vdv_aus.read_matches", "restored {} of {} matches",
+      n_restored, snapshot->entries_.size());
+  return n_restored;
+}
+
 statistics updater::update(rt_timetable& rtt, pugi::xml_document const& doc) {
+  auto span = get_otel_tracer()->StartSpan(
+      "vdv_aus::updater::update",
+      {{"nigiri.vdv_aus.src", static_cast<std::uint32_t>(to_idx(src_idx_))}});
+  auto scope = opentelemetry::trace::Scope{span};
+  auto const update_start = std::chrono::steady_clock::now();
+
   if (std::chrono::system_clock::now() - last_cleanup > kCleanUpInterval) {
     clean_up();
   }
 
   auto stats = statistics{};
 
+  auto runs = std::vector<parsed_run>{};
   auto const process = [&](pugi::xml_node const vdv_run) {
     if (*get_opt_bool(vdv_run, is_vdv(format_) ? "Zusatzfahrt" : "ExtraJourney",
                       false)) {
@@ -884,7 +1404,9 @@ statistics updater::update(rt_timetable& rtt, pugi::xml_document const& doc) {
       ++stats.unsupported_additional_runs_;
       return;
     }
-    process_vdv_run(rtt, vdv_run, stats);
+    if (auto r = parse_run(vdv_run, stats); r.has_value()) {
+      runs.emplace_back(std::move(*r));
+    }
   };
 
   switch (format_) {
@@ -921,12 +1443,86 @@ statistics updater::update(rt_timetable& rtt, pugi::xml_document const& doc) {
       break;
   }
 
+  process_runs(rtt, runs, stats);
+
   for (auto const vdv_alert :
        children(doc, "Siri", "ServiceDelivery", "SituationExchangeDelivery",
                 "Situations", "PtSituationElement")) {
     process_vdv_alert(rtt, vdv_alert);
   }
 
+  update_cumulative_stats(stats);
+  finish_update_span(*span, stats, format_, update_start);
+
+  return stats;
+}
+
+statistics updater::update(rt_timetable& rtt, std::string_view siri_json) {
+  auto span = get_otel_tracer()->StartSpan(
+      "vdv_aus::updater::update",
+      {{"nigiri.vdv_aus.src", static_cast<std::uint32_t>(to_idx(src_idx_))},
+       {"nigiri.vdv_aus.payload_size", siri_json.size()}});
+  auto scope = opentelemetry::trace::Scope{span};
+  auto const update_start = std::chrono::steady_clock::now();
+
+  if (std::chrono::system_clock::now() - last_cleanup > kCleanUpInterval) {
+    clean_up();
+  }
+
+  auto stats = statistics{};
+
+  auto const parse_start = std::chrono::steady_clock::now();
+  auto mr = boost::json::monotonic_resource{};
+  auto ec = boost::system::error_code{};
+  auto const root = boost::json::parse(siri_json, ec, &mr);
+  stats.parse_time_ = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - parse_start);
+  utl::verify(!ec, "vdv_aus: unable to parse SIRI-JSON: {}", ec.message());
+  utl::verify(root.is_object(), "vdv_aus: SIRI-JSON root must be an object");
+
+  auto const& delivery = root.get_object();
+
+  auto runs = std::vector<parsed_run>{};
+  auto const process = [&](boost::json::object const& vdv_run) {
+    if (*get_opt_bool(vdv_run, "extraJourney", false)) {
+      vdv_trace("unsupported additional run\n");
+      ++stats.unsupported_additional_runs_;
+      return;
+    }
+    if (auto r = parse_run(vdv_run, stats); r.has_value()) {
+      runs.emplace_back(std::move(*r));
+    }
+  };
+
+  auto const process_frames = [&](boost::json::object const& o) {
+    for_each_object(o, "estimatedJourneyVersionFrame", [&](auto const& frame) {
+      for_each_object(frame, "estimatedVehicleJourney", process);
+    });
+  };
+
+  for_each_object(delivery, "estimatedTimetableDelivery", process_frames);
+  process_frames(delivery);
+  for_each_object(delivery, "estimatedVehicleJourney", process);
+
+  process_runs(rtt, runs, stats);
+
+  if (delivery.contains("situationExchangeDelivery")) {
+    // Alerts are rare compared to estimated timetables: keep the XML path.
+    auto const doc = to_xml(siri_json);
+    for (auto const vdv_alert :
+         children(doc, "Siri", "ServiceDelivery", "SituationExchangeDelivery",
+                  "Situations", "PtSituationElement")) {
+      process_vdv_alert(rtt, vdv_alert);
+    }
+  }
+
+  update_cumulative_stats(stats);
+  finish_update_span(*span, stats, format_, update_start);
+
+  return stats;
+}
+
+void updater::update_cumulative_stats(statistics const& stats) {
   cumulative_stats_ += stats;
   cumulative_stats_.current_matches_total_ = matches_.size();
   cumulative_stats_.current_matches_non_empty_ = [&]() {
@@ -936,8 +1532,6 @@ statistics updater::update(rt_timetable& rtt, pugi::xml_document const& doc) {
     }
     return n;
   }();
-
-  return stats;
 }
 
 }  // namespace nigiri::rt::vdv_aus
\ No newline at end of file
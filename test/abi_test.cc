@@ -3,6 +3,8 @@
 #include "date/date.h"
 
 #include <cstdint>
+#include <tuple>
+#include <vector>
 #include "nigiri/loader/dir.h"
 #include "nigiri/abi.h"
 #include "nigiri/rt/util.h"
@@ -573,3 +575,76 @@ TEST(rt, abi_journeys) {
   nigiri_destroy_journeys(journeys);
   nigiri_destroy(t);
 }
+
+TEST(rt, abi_incremental_rt_update) {
+  auto const load = []() {
+    return nigiri_load_from_dir(
+        test_files(),
+        std::chrono::system_clock::to_time_t(
+            date::sys_days{2023_y / August / 9}),
+        std::chrono::system_clock::to_time_t(
+            date::sys_days{2023_y / August / 12}),
+        0);
+  };
+  auto const to_tuple = [](nigiri_event_change_t const& c) {
+    return std::tuple{c.transport_idx,       c.day_idx,
+                      c.stop_idx,            c.is_departure,
+                      c.stop_change,         c.stop_location_idx,
+                      c.stop_in_out_allowed, c.delay};
+  };
+
+  auto const msg = rt::json_to_protobuf(kTripUpdate);
+
+  using changes_t = std::vector<nigiri_event_change_t>;
+  auto const collect_change = [](nigiri_event_change_t const c,
+                                 void* context) {
+    static_cast<changes_t*>(context)->push_back(c);
+  };
+  auto const collect_batch = [](nigiri_event_change_t const* changes,
+                                uint32_t const n, void* context) {
+    static_cast<std::vector<changes_t>*>(context)->emplace_back(changes,
+                                                                changes + n);
+  };
+
+  auto const t = load();
+  auto changes = changes_t{};
+  nigiri_update_with_rt_from_memory(t, msg.data(), msg.size(), collect_change,
+                                    &changes);
+  ASSERT_EQ(31U, changes.size());
+
+  // Same feed again: nothing changed.
+  auto repeated = changes_t{};
+  nigiri_update_with_rt_from_memory(t, msg.data(), msg.size(), collect_change,
+                                    &repeated);
+  EXPECT_TRUE(repeated.empty());
+
+  // Batched on a fresh timetable: the same changes in batches of 8.
+  auto const batched_t = load();
+  auto batches = std::vector<changes_t>{};
+  nigiri_update_with_rt_from_memory_batched(batched_t, msg.data(), msg.size(),
+                                            8U, collect_batch, &batches);
+  ASSERT_EQ(4U, batches.size());
+  EXPECT_EQ(8U, batches[0].size());
+  EXPECT_EQ(8U, batches[1].size());
+  EXPECT_EQ(8U, batches[2].size());
+  EXPECT_EQ(7U, batches[3].size());
+
+  auto i = 0U;
+  for (auto const& batch : batches) {
+    for (auto const& c : batch) {
+      ASSERT_LT(i, changes.size());
+      EXPECT_EQ(to_tuple(changes[i]), to_tuple(c));
+      ++i;
+    }
+  }
+  EXPECT_EQ(changes.size(), i);
+
+  // Same feed again: no batches.
+  batches.clear();
+  nigiri_update_with_rt_from_memory_batched(batched_t, msg.data(), msg.size(),
+                                            8U, collect_batch, &batches);
+  EXPECT_TRUE(batches.empty());
+
+  nigiri_destroy(batched_t);
+  nigiri_destroy(t);
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include <random>
+
+#include "nigiri/compressed_bitfields.h"
+
+using namespace nigiri;
+
+TEST(compressed_bitfields, roundtrip) {
+  auto rng = std::mt19937{42U};
+  auto day_dist = std::uniform_int_distribution<std::size_t>{0U, kMaxDays - 1U};
+
+  auto bitfields = vector_map<bitfield_idx_t, bitfield>{};
+  bitfields.emplace_back(bitfield{});
+  bitfields.emplace_back(bitfield{"1111100111110011111"});
+  for (auto i = 0U; i != 100U; ++i) {
+    auto bf = bitfield{};
+    for (auto j = 0U; j != 50U; ++j) {
+      bf.set(day_dist(rng));
+    }
+    bitfields.emplace_back(bf);
+  }
+
+  auto const c = compress(bitfields);
+  ASSERT_EQ(bitfields.size(), c.size());
+  for (auto x = 0U; x != bitfields.size(); ++x) {
+    auto const i = bitfield_idx_t{x};
+    EXPECT_EQ(bitfields[i], c[i].to_bitfield());
+    EXPECT_TRUE(c[i] == bitfields[i]);
+    EXPECT_EQ(bitfields[i].none(), c[i].none());
+    for (auto day = 0U; day != kMaxDays; ++day) {
+      EXPECT_EQ(bitfields[i].test(day), c[i].test(day));
+    }
+    for (auto y = 0U; y != bitfields.size(); ++y) {
+      auto const j = bitfield_idx_t{y};
+      EXPECT_EQ((bitfields[i] & bitfields[j]).any(), c.intersects(i, j));
+    }
+  }
+}
+
+TEST(compressed_bitfields, add_without_shares_blocks) {
+  auto bf = bitfield{};
+  for (auto day = 0U; day != 365U; ++day) {
+    bf.set(day, day % 7U < 5U);
+  }
+
+  auto c = compressed_bitfields<bitfield_idx_t>{};
+  auto const a = c.add(bf);
+  auto const n_blocks = c.dict_.size();
+
+  auto const b = c.add_without(a, 100U);
+  EXPECT_EQ(bitfield_idx_t{1U}, b);
+  EXPECT_FALSE(c[b].test(100U));
+  EXPECT_TRUE(c[a].test(100U));
+  EXPECT_EQ(n_blocks + 1U, c.dict_.size());
+
+  bf.set(100U, false);
+  EXPECT_EQ(bf, c[b].to_bitfield());
+}
@@ -492,6 +492,10 @@ id=three_zone_single_ticket, name=Children Three Zone Ticket [priority=0]: 2.2 E
 
 )";
   EXPECT_EQ(kExpected, to_string(tt, nullptr, fare_legs));
+
+  auto const batch = get_fares(tt, nullptr, results);
+  ASSERT_EQ(1U, batch.size());
+  EXPECT_EQ(kExpected, to_string(tt, nullptr, batch.front()));
 }
 
 TEST(fares, simple_fares) {
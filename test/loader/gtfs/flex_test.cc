@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 
+#include "utl/enumerate.h"
 #include "utl/zip.h"
 
 #include "nigiri/loader/gtfs/load_timetable.h"
@@ -186,3 +187,45 @@ TRANSPORT 5 [odv_j25_1_1_29_29_77+_4]
       R"([{"idx":0,"firstDay":"2025-01-01","lastDay":"2025-11-30","noLocations":3,"noTrips":7,"transportsXDays":670}])",
       to_str(get_metrics(tt), tt));
 }
+
+TEST(flex, area_index) {
+  constexpr auto const kArea = flex_area_idx_t{0};
+
+  auto tt = loader::load({{.tag_ = "test",
+                           .path_ = kTimetable,
+                           .loader_config_ = {.default_tz_ = "Europe/Berlin"}}},
+                         {},
+                         {date::sys_days{2025_y / January / 1},
+                          date::sys_days{2025_y / December / 1}});
+  ASSERT_EQ(1U, tt.flex_area_cells_.size());
+
+  auto const& box = tt.flex_area_bbox_[kArea];
+  auto positions = std::vector<geo::latlng>{};
+  for (auto y = 0U; y != 50U; ++y) {
+    for (auto x = 0U; x != 50U; ++x) {
+      positions.emplace_back(
+          box.min_.lat_ + (box.max_.lat_ - box.min_.lat_) * y / 49.0,
+          box.min_.lng_ + (box.max_.lng_ - box.min_.lng_) * x / 49.0);
+    }
+  }
+
+  auto indexed = std::vector<bool>{};
+  for (auto const& pos : positions) {
+    indexed.push_back(is_in_flex_area(tt, kArea, pos));
+  }
+
+  auto batch = bitvec{};
+  is_in_flex_area(tt, kArea, positions, batch);
+
+  // Without index: exact test for every position.
+  tt.flex_area_cells_.clear();
+  auto n_inside = 0U;
+  for (auto const [i, pos] : utl::enumerate(positions)) {
+    auto const exact = is_in_flex_area(tt, kArea, pos);
+    EXPECT_EQ(exact, indexed[i]);
+    EXPECT_EQ(exact, batch.test(i));
+    n_inside += exact ? 1U : 0U;
+  }
+  EXPECT_NE(0U, n_inside);
+  EXPECT_NE(positions.size(), n_inside);
+}
@@ -2,6 +2,7 @@
 
 #include "utl/zip.h"
 
+#include "nigiri/loader/compact_transports.h"
 #include "nigiri/loader/dir.h"
 #include "nigiri/loader/gtfs/files.h"
 #include "nigiri/loader/gtfs/load_timetable.h"
@@ -596,3 +597,38 @@ TEST(loader, merge_reflexive_matching) {
         tt.bitfields_[tt.transport_traffic_days_[tr_range_a.first]].none());
   }
 }
+
+TEST(loader, merge_compacts_transports) {
+  auto tt = timetable{};
+  tt.date_range_ = {date::sys_days{2024_y / August / 5},
+                    date::sys_days{2024_y / December / 14}};
+  register_special_stations(tt);
+  load_timetable({}, source_idx_t{0}, rbo500_a_files(), tt);
+
+  auto const n_transports = tt.next_transport_idx();
+  finalize(tt, false, true, false);
+  EXPECT_LT(tt.next_transport_idx(), n_transports);
+
+  for (auto t = transport_idx_t{0U}; t != tt.next_transport_idx(); ++t) {
+    EXPECT_FALSE(tt.bitfields_[tt.transport_traffic_days_[t]].none());
+    EXPECT_TRUE(
+        tt.route_transport_ranges_[tt.transport_route_[t]].contains(t));
+  }
+  for (auto r = route_idx_t{0U}; r != tt.n_routes(); ++r) {
+    EXPECT_FALSE(tt.route_transport_ranges_[r].empty());
+    auto const n_columns = tt.route_headways_[r].empty()
+                               ? tt.route_transport_ranges_[r].size()
+                               : 1U;
+    EXPECT_EQ(tt.route_stop_time_ranges_[r].size(),
+              n_columns * (tt.route_location_seq_[r].size() - 1U) * 2U);
+  }
+  for (auto trip = trip_idx_t{0U}; trip != tt.n_trips(); ++trip) {
+    for (auto const& [t, range] : tt.trip_transport_ranges_[trip]) {
+      EXPECT_LT(t, tt.next_transport_idx());
+    }
+  }
+
+  auto const stats = compact_transports(tt);
+  EXPECT_EQ(0U, stats.removed_transports_);
+  EXPECT_EQ(0U, stats.removed_routes_);
+}
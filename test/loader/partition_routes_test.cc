@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "nigiri/loader/partition_routes.h"
+#include "nigiri/types.h"
+
+using namespace nigiri;
+using namespace nigiri::loader;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct service {
+  std::vector<duration_t> utc_times_;
+};
+
+service make(duration_t const first, std::vector<duration_t> const& travel) {
+  auto s = service{{first}};
+  for (auto const t : travel) {
+    s.utc_times_.push_back(s.utc_times_.back() + t);
+  }
+  return s;
+}
+
+}  // namespace
+
+TEST(loader, partition_routes_fifo) {
+  auto services = std::vector<service>{
+      make(10h, {10min, 10min}), make(8h, {10min, 10min}),
+      make(9h, {10min, 10min}),
+      // Express: departs after the 9:00 service, arrives before it.
+      make(9h + 5min, {1min, 1min}),
+      // Departs at 07:00 on the next day: sorted first (modulo one day).
+      make(24h + 7h, {10min, 10min})};
+
+  auto const routes = partition_routes(std::move(services));
+  ASSERT_EQ(2U, routes.size());
+
+  auto n_services = 0U;
+  for (auto const& r : routes) {
+    n_services += r.size();
+    for (auto i = 1U; i < r.size(); ++i) {
+      for (auto j = 0U; j != r[i].utc_times_.size(); ++j) {
+        EXPECT_LE(r[i - 1].utc_times_[j] % 1440, r[i].utc_times_[j] % 1440);
+      }
+    }
+  }
+  EXPECT_EQ(5U, n_services);
+  EXPECT_EQ(3U, routes[0].size());
+  EXPECT_EQ(2U, routes[1].size());
+  EXPECT_EQ(7h, routes[0].front().utc_times_.front() % 1440);
+}
@@ -0,0 +1,98 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "nigiri/loader/gtfs/load_timetable.h"
+#include "nigiri/loader/init_finish.h"
+#include "nigiri/mapped_timetable.h"
+
+using namespace date;
+using namespace nigiri;
+using namespace nigiri::loader;
+using namespace nigiri::loader::gtfs;
+
+namespace {
+
+mem_dir test_files() {
+  return mem_dir::read(R"(
+# agency.txt
+agency_id,agency_name,agency_url,agency_timezone
+DB,Deutsche Bahn,https://deutschebahn.com,Europe/Berlin
+
+# stops.txt
+stop_id,stop_name,stop_desc,stop_lat,stop_lon,stop_url,location_type,parent_station
+A,A,,0.0,1.0,,
+B,B,,2.0,3.0,,
+
+# calendar_dates.txt
+service_id,date,exception_type
+S_RE1,20190501,1
+
+# routes.txt
+route_id,agency_id,route_short_name,route_long_name,route_desc,route_type
+R_RE1,DB,RE 1,,,3
+
+# trips.txt
+route_id,service_id,trip_id,trip_headsign,block_id
+R_RE1,S_RE1,T_RE1,RE 1,
+
+# stop_times.txt
+trip_id,arrival_time,departure_time,stop_id,stop_sequence,pickup_type,drop_off_type
+T_RE1,12:00:00,12:00:00,A,1,0,0
+T_RE1,13:00:00,13:00:00,B,2,0,0
+)");
+}
+
+std::filesystem::path write_test_timetable(std::string_view const name) {
+  auto tt = timetable{};
+  tt.date_range_ = {date::sys_days{2019_y / March / 25},
+                    date::sys_days{2019_y / November / 1}};
+  load_timetable({}, source_idx_t{0}, test_files(), tt);
+  finalize(tt);
+
+  auto const p = std::filesystem::temp_directory_path() / name;
+  tt.write(p);
+  return p;
+}
+
+void check_round_trip(mapped_timetable::checksum_check const checksum) {
+  auto const p = write_test_timetable("mapped-timetable-round-trip");
+  {
+    auto m = mapped_timetable::read(p, {.checksum_ = checksum});
+    EXPECT_TRUE(m.checksum_ok());
+    EXPECT_EQ(1U, m->transport_traffic_days_.size());
+    auto const a = m->locations_.location_id_to_idx_.at(
+        {.id_ = "A", .src_ = source_idx_t{0}});
+    EXPECT_EQ("A", m->get_default_name(a));
+  }
+  std::filesystem::remove(p);
+}
+
+}  // namespace
+
+TEST(mapped_timetable, round_trip_eager) {
+  check_round_trip(mapped_timetable::checksum_check::kEager);
+}
+
+TEST(mapped_timetable, round_trip_background) {
+  check_round_trip(mapped_timetable::checksum_check::kBackground);
+}
+
+TEST(mapped_timetable, round_trip_skip) {
+  check_round_trip(mapped_timetable::checksum_check::kSkip);
+}
+
+TEST(mapped_timetable, corrupted) {
+  auto const p = write_test_timetable("mapped-timetable-corrupted");
+  {
+    auto f = std::fstream{p, std::ios::in | std::ios::out | std::ios::binary};
+    f.seekg(-1, std::ios::end);
+    auto const last = static_cast<char>(f.get());
+    f.seekp(-1, std::ios::end);
+    f.put(static_cast<char>(~last));
+  }
+  EXPECT_ANY_THROW(mapped_timetable::read(
+      p, {.checksum_ = mapped_timetable::checksum_check::kEager}));
+  std::filesystem::remove(p);
+}
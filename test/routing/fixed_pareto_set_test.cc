@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "nigiri/routing/fixed_pareto_set.h"
+#include "nigiri/routing/pareto_set.h"
+#include "nigiri/routing/tb/reached.h"
+
+using namespace nigiri;
+using namespace nigiri::routing::tb;
+
+namespace {
+
+std::vector<std::array<std::uint16_t, 3U>> sorted_criteria(auto const& s) {
+  auto v = std::vector<std::array<std::uint16_t, 3U>>{};
+  for (auto const& e : s) {
+    v.emplace_back(e.criteria());
+  }
+  std::sort(begin(v), end(v));
+  return v;
+}
+
+}  // namespace
+
+TEST(routing, fixed_pareto_set) {
+  auto rng = std::mt19937{42U};
+  auto k_dist = std::uniform_int_distribution<std::uint16_t>{0U, 7U};
+  auto value_dist = std::uniform_int_distribution<std::uint16_t>{0U, 40U};
+
+  for (auto const n_adds : {4U, 16U, 200U}) {
+    auto fixed = fixed_pareto_set<entry, 8U>{};
+    for (auto run = 0U; run != 20U; ++run) {
+      auto generic = pareto_set<entry>{};
+      fixed.clear();
+      for (auto i = 0U; i != n_adds; ++i) {
+        auto const e = entry{.transport_ = value_dist(rng),
+                             .segment_offset_ = value_dist(rng),
+                             .k_ = k_dist(rng)};
+        auto const added_fixed = fixed.add(e);
+        auto const added_generic = std::get<0>(generic.add(entry{e}));
+        ASSERT_EQ(added_generic, added_fixed);
+        ASSERT_EQ(generic.size(), fixed.size());
+      }
+      EXPECT_EQ(sorted_criteria(generic), sorted_criteria(fixed));
+    }
+  }
+}
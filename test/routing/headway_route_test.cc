@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "nigiri/loader/gtfs/load_timetable.h"
+#include "nigiri/loader/init_finish.h"
+#include "nigiri/rt/frun.h"
+
+#include "../raptor_search.h"
+
+using namespace date;
+using namespace nigiri;
+using namespace nigiri::loader;
+using namespace nigiri::loader::gtfs;
+using nigiri::test::raptor_search;
+
+namespace {
+
+// F: A -> B -> C every 10 minutes between 06:00 and 08:00 (frequencies.txt)
+// R: A -> D twice, too few transports for a headway route
+mem_dir test_files() {
+  return mem_dir::read(R"(
+# agency.txt
+agency_id,agency_name,agency_url,agency_timezone
+DB,Deutsche Bahn,https://deutschebahn.com,Europe/Berlin
+
+# stops.txt
+stop_id,stop_name,stop_desc,stop_lat,stop_lon,stop_url,location_type,parent_station
+A,A,,0.0,1.0,,
+B,B,,2.0,3.0,,
+C,C,,4.0,5.0,,
+D,D,,6.0,7.0,,
+
+# calendar_dates.txt
+service_id,date,exception_type
+S,20190501,1
+
+# routes.txt
+route_id,agency_id,route_short_name,route_long_name,route_desc,route_type
+F,DB,F,,,1
+R,DB,R,,,3
+
+# trips.txt
+route_id,service_id,trip_id,trip_headsign,block_id
+F,S,F1,F,
+R,S,R1,R,
+R,S,R2,R,
+
+# stop_times.txt
+trip_id,arrival_time,departure_time,stop_id,stop_sequence,pickup_type,drop_off_type
+F1,06:00:00,06:00:00,A,1,0,0
+F1,06:10:00,06:11:00,B,2,0,0
+F1,06:25:00,06:25:00,C,3,0,0
+R1,06:00:00,06:00:00,A,1,0,0
+R1,06:30:00,06:30:00,D,2,0,0
+R2,07:00:00,07:00:00,A,1,0,0
+R2,07:30:00,07:30:00,D,2,0,0
+
+# frequencies.txt
+trip_id,start_time,end_time,headway_secs
+F1,06:00:00,08:00:00,600
+)");
+}
+
+std::vector<std::pair<unixtime_t, unixtime_t>> dep_arr(
+    pareto_set<routing::journey> const& journeys) {
+  auto times = std::vector<std::pair<unixtime_t, unixtime_t>>{};
+  for (auto const& j : journeys) {
+    times.emplace_back(j.departure_time(), j.arrival_time());
+  }
+  std::sort(begin(times), end(times));
+  return times;
+}
+
+}  // namespace
+
+TEST(routing, headway_route) {
+  constexpr auto const src = source_idx_t{0U};
+
+  auto tt = timetable{};
+  tt.date_range_ = {sys_days{2019_y / May / 1}, sys_days{2019_y / May / 2}};
+  load_timetable({}, src, test_files(), tt);
+  finalize(tt);
+
+  auto const a =
+      tt.locations_.location_id_to_idx_.at({.id_ = "A", .src_ = src});
+  auto f = route_idx_t::invalid();
+  auto r = route_idx_t::invalid();
+  for (auto const x : tt.location_routes_[a]) {
+    (tt.route_location_seq_[x].size() == 3U ? f : r) = x;
+  }
+  ASSERT_NE(route_idx_t::invalid(), f);
+  ASSERT_NE(route_idx_t::invalid(), r);
+
+  // Only the template transport of F is stored: 2 events per segment.
+  ASSERT_EQ(12U, tt.route_transport_ranges_[f].size());
+  ASSERT_EQ(1U, tt.route_headways_[f].size());
+  EXPECT_EQ(10U, tt.route_headways_[f][0].headway_);
+  EXPECT_EQ(4U, tt.route_stop_time_ranges_[f].size());
+
+  ASSERT_EQ(2U, tt.route_transport_ranges_[r].size());
+  EXPECT_TRUE(tt.route_headways_[r].empty());
+  EXPECT_EQ(2U * 2U, tt.route_stop_time_ranges_[r].size());
+
+  // Concrete trips are synthesized from the template (Berlin = UTC+2).
+  auto const base = unixtime_t{sys_days{2019_y / May / 1}} + 4_hours;
+  auto const day = tt.day_idx(2019_y / May / 1);
+  auto i = 0;
+  for (auto const t : tt.route_transport_ranges_[f]) {
+    auto const fr = rt::frun::from_t(tt, nullptr, transport{t, day});
+    auto const offset = i++ * 10_minutes;
+    EXPECT_EQ(base + offset, fr[0].time(event_type::kDep));
+    EXPECT_EQ(base + offset + 10_minutes, fr[1].time(event_type::kArr));
+    EXPECT_EQ(base + offset + 11_minutes, fr[1].time(event_type::kDep));
+    EXPECT_EQ(base + offset + 25_minutes, fr[2].time(event_type::kArr));
+  }
+
+  auto const expected = std::vector<std::pair<unixtime_t, unixtime_t>>{
+      {base + 40_minutes, base + 65_minutes},
+      {base + 50_minutes, base + 75_minutes}};
+
+  // Boarding computes the next departure from the headway windows.
+  EXPECT_EQ(expected, dep_arr(raptor_search(
+                          tt, nullptr, "A", "C",
+                          interval{base + 31_minutes, base + 51_minutes})));
+  EXPECT_EQ(expected, dep_arr(raptor_search(
+                          tt, nullptr, "C", "A",
+                          interval{base + 65_minutes, base + 76_minutes},
+                          direction::kBackward)));
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+
+#include "nigiri/loader/gtfs/load_timetable.h"
+#include "nigiri/loader/init_finish.h"
+#include "nigiri/routing/interval_estimate.h"
+
+using namespace date;
+using namespace nigiri;
+using namespace nigiri::loader;
+using namespace nigiri::loader::gtfs;
+using namespace std::chrono_literals;
+
+namespace {
+
+mem_dir test_files() {
+  return mem_dir::read(R"(
+# agency.txt
+agency_id,agency_name,agency_url,agency_timezone
+DB,Deutsche Bahn,https://deutschebahn.com,Europe/Berlin
+
+# stops.txt
+stop_id,stop_name,stop_desc,stop_lat,stop_lon,stop_url,location_type,parent_station
+A,A,,0.0,1.0,,
+B,B,,2.0,3.0,,
+
+# calendar_dates.txt
+service_id,date,exception_type
+S_RE1,20190501,1
+
+# routes.txt
+route_id,agency_id,route_short_name,route_long_name,route_desc,route_type
+R_RE1,DB,RE 1,,,3
+
+# trips.txt
+route_id,service_id,trip_id,trip_headsign,block_id
+R_RE1,S_RE1,T_RE1,RE 1,
+R_RE1,S_RE1,T_RE2,RE 1,
+R_RE1,S_RE1,T_RE3,RE 1,
+
+# stop_times.txt
+trip_id,arrival_time,departure_time,stop_id,stop_sequence,pickup_type,drop_off_type
+T_RE1,12:00:00,12:00:00,A,1,0,0
+T_RE1,13:00:00,13:00:00,B,2,0,0
+T_RE2,13:00:00,13:00:00,A,1,0,0
+T_RE2,14:00:00,14:00:00,B,2,0,0
+T_RE3,14:00:00,14:00:00,A,1,0,0
+T_RE3,15:00:00,15:00:00,B,2,0,0
+)");
+}
+
+}  // namespace
+
+TEST(routing, interval_estimate_from_services) {
+  timetable tt;
+  tt.date_range_ = {date::sys_days{2019_y / March / 25},
+                    date::sys_days{2019_y / November / 1}};
+  auto const src = source_idx_t{0};
+  load_timetable({}, src, test_files(), tt);
+  finalize(tt);
+
+  auto const a =
+      tt.locations_.location_id_to_idx_.at({.id_ = "A", .src_ = src});
+  auto const b =
+      tt.locations_.location_id_to_idx_.at({.id_ = "B", .src_ = src});
+
+  // One service day: one transport per hour (16/16) in UTC.
+  EXPECT_EQ(16U, tt.location_hourly_departures_[a][10]);
+  EXPECT_EQ(16U, tt.location_hourly_departures_[a][12]);
+  EXPECT_EQ(0U, tt.location_hourly_departures_[a][13]);
+  EXPECT_EQ(0U, tt.location_hourly_arrivals_[a][10]);
+  EXPECT_EQ(0U, tt.location_hourly_departures_[b][11]);
+  EXPECT_EQ(0U, tt.location_hourly_arrivals_[b][10]);
+  EXPECT_EQ(16U, tt.location_hourly_arrivals_[b][11]);
+  EXPECT_EQ(16U, tt.location_hourly_arrivals_[b][13]);
+
+  auto const start = unixtime_t{date::sys_days{2019_y / May / 1} + 10_hours};
+  auto q = routing::query{.start_time_ = interval{start, start},
+                          .start_ = {{a, 0_minutes, 0U}},
+                          .destination_ = {{b, 0_minutes, 0U}},
+                          .min_connection_count_ = 1U,
+                          .extend_interval_later_ = true};
+
+  // One hour per connection (+1 hour).
+  auto const fixed = routing::interval_estimator<direction::kForward>{tt, q}
+                         .initial(interval{start, start});
+  EXPECT_EQ(start + 2_hours, fixed.to_);
+
+  // Without travel time: departures at A and arrivals at B only overlap
+  // between 11:00 and 13:00, the two transports (one connection with margin)
+  // are expected 3 hours after the start (+1 hour).
+  q.estimate_interval_from_services_ = true;
+  auto const without_lb =
+      routing::interval_estimator<direction::kForward>{tt, q}.initial(
+          interval{start, start});
+  EXPECT_EQ(start, without_lb.from_);
+  EXPECT_EQ(start + 4_hours, without_lb.to_);
+
+  // Departures at A between 10:00 and 13:00 arrive at B one hour later: the
+  // two transports are expected 2 hours after the start (+1 hour).
+  auto lb = std::vector<std::uint16_t>(
+      tt.n_locations(), std::numeric_limits<std::uint16_t>::max());
+  lb[to_idx(a)] = 60U;
+  lb[to_idx(b)] = 0U;
+  auto const with_lb =
+      routing::interval_estimator<direction::kForward>{tt, q, lb}.initial(
+          interval{start, start});
+  EXPECT_EQ(start, with_lb.from_);
+  EXPECT_EQ(start + 3_hours, with_lb.to_);
+}
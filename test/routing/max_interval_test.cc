@@ -99,4 +99,46 @@ TEST(routing, max_interval) {
               unixtime_t{date::sys_days{2019_y / May / 1} + 12_hours}}});
 
   EXPECT_EQ(expected_journeys, to_string(tt, nullptr, results));
-}
\ No newline at end of file
+}
+
+TEST(routing, interval_extension_both_sides) {
+  timetable tt;
+  tt.date_range_ = {date::sys_days{2019_y / March / 25},
+                    date::sys_days{2019_y / November / 1}};
+  auto const src = source_idx_t{0};
+  load_timetable({}, src, test_files(), tt);
+  finalize(tt);
+
+  auto const a =
+      tt.locations_.location_id_to_idx_.at({.id_ = "A", .src_ = src});
+  auto const b =
+      tt.locations_.location_id_to_idx_.at({.id_ = "B", .src_ = src});
+  auto const max_interval =
+      interval{unixtime_t{date::sys_days{2019_y / May / 1} + 10_hours},
+               unixtime_t{date::sys_days{2019_y / May / 1} + 12_hours + 1min}};
+
+  // Extending later resets the arrivals, extending earlier has to see the
+  // arrivals of the initial interval and of the later extension again.
+  auto const extended = raptor_search(
+      tt, nullptr,
+      nigiri::routing::query{
+          .start_time_ =
+              interval{unixtime_t{date::sys_days{2019_y / May / 1} + 11_hours},
+                       unixtime_t{date::sys_days{2019_y / May / 1} + 11_hours +
+                                  1min}},
+          .start_ = {{a, 0_minutes, 0U}},
+          .destination_ = {{b, 0_minutes, 0U}},
+          .min_connection_count_ = 3U,
+          .extend_interval_earlier_ = true,
+          .extend_interval_later_ = true,
+          .max_interval_ = max_interval});
+
+  auto const direct = raptor_search(
+      tt, nullptr,
+      nigiri::routing::query{.start_time_ = max_interval,
+                             .start_ = {{a, 0_minutes, 0U}},
+                             .destination_ = {{b, 0_minutes, 0U}}});
+
+  EXPECT_EQ(3U, extended.size());
+  EXPECT_EQ(to_string(tt, nullptr, direct), to_string(tt, nullptr, extended));
+}
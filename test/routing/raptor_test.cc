@@ -2,6 +2,7 @@
 
 #include "nigiri/loader/hrd/load_timetable.h"
 #include "nigiri/loader/init_finish.h"
+#include "nigiri/routing/raptor_search.h"
 
 #include "../loader/hrd/hrd_timetable.h"
 
@@ -59,6 +60,37 @@ TEST(routing, raptor_forward) {
   EXPECT_EQ(std::string_view{fwd_journeys}, to_string(tt, results));
 }
 
+TEST(routing, raptor_forward_reconstruct_on_demand) {
+  constexpr auto const src = source_idx_t{0U};
+
+  timetable tt;
+  tt.date_range_ = full_period();
+  load_timetable(src, loader::hrd::hrd_5_20_26, files_abc(), tt);
+  finalize(tt);
+
+  auto const q = routing::query{
+      .start_time_ =
+          interval{unixtime_t{sys_days{2020_y / March / 30}} + 5_hours,
+                   unixtime_t{sys_days{2020_y / March / 30}} + 6_hours},
+      .start_ = {{tt.locations_.location_id_to_idx_.at({"0000001", src}),
+                  0_minutes, 0U}},
+      .destination_ = {{tt.locations_.location_id_to_idx_.at({"0000003", src}),
+                        0_minutes, 0U}},
+      .reconstruct_legs_ = false};
+
+  auto headers = raptor_search(tt, nullptr, q);
+  ASSERT_EQ(2U, headers.size());
+  for (auto const& j : headers) {
+    EXPECT_TRUE(j.legs_.empty());
+  }
+
+  auto s_state = routing::search_state{};
+  auto r_state = routing::raptor_state{};
+  routing::reconstruct_legs(tt, nullptr, s_state, r_state, q,
+                            direction::kForward, headers.els_);
+  EXPECT_EQ(std::string_view{fwd_journeys}, to_string(tt, headers));
+}
+
 constexpr auto const bwd_journeys = R"(
 [2020-03-30 03:00, 2020-03-30 05:15]
 TRANSFERS: 1
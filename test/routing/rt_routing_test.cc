@@ -11,6 +11,7 @@
 #include "../loader/hrd/hrd_timetable.h"
 
 #include "../raptor_search.h"
+#include "../rt/util.h"
 #include "results_to_string.h"
 
 using namespace date;
@@ -317,4 +318,87 @@ TEST(routing, rt_raptor_unscheduled) {
 
   EXPECT_EQ(std::string_view{unscheduled_journeys},
             to_string(tt, &rtt, results));
-}
\ No newline at end of file
+}
+
+namespace {
+
+mem_dir rt_route_files() {
+  return mem_dir::read(R"(
+# agency.txt
+agency_id,agency_name,agency_url,agency_timezone
+DB,Deutsche Bahn,https://deutschebahn.com,Europe/Berlin
+
+# stops.txt
+stop_id,stop_name,stop_desc,stop_lat,stop_lon,stop_url,location_type,parent_station
+A,A,,0.0,1.0,,
+B,B,,0.02,1.03,,
+C,C,,0.04,1.05,,
+
+# calendar_dates.txt
+service_id,date,exception_type
+S,20190503,1
+
+# routes.txt
+route_id,agency_id,route_short_name,route_long_name,route_desc,route_type
+R,DB,RE 1,,,3
+
+# trips.txt
+route_id,service_id,trip_id,trip_headsign,block_id
+R,S,T1,RE 1,
+R,S,T2,RE 1,
+
+# stop_times.txt
+trip_id,arrival_time,departure_time,stop_id,stop_sequence,pickup_type,drop_off_type
+T1,10:00:00,10:00:00,A,1,0,0
+T1,10:10:00,10:10:00,B,2,0,0
+T1,10:20:00,10:20:00,C,3,0,0
+T2,10:30:00,10:30:00,A,1,0,0
+T2,10:40:00,10:40:00,B,2,0,0
+T2,10:50:00,10:50:00,C,3,0,0
+)");
+}
+
+}  // namespace
+
+TEST(routing, rt_routes_fifo) {
+  timetable tt;
+  tt.date_range_ = {date::sys_days{2019_y / March / 25},
+                    date::sys_days{2019_y / November / 1}};
+  load_timetable({}, source_idx_t{0}, rt_route_files(), tt);
+  finalize(tt);
+
+  auto rtt = rt::create_rt_timetable(tt, date::sys_days{2019_y / May / 3});
+
+  // Both trips on time: one RT route.
+  auto const on_time = rt::gtfsrt_update_msg(
+      tt, rtt, source_idx_t{0}, "tag",
+      test::to_feed_msg(
+          {test::trip{"T1", {{.seq_ = 1U, .ev_type_ = event_type::kDep}}},
+           test::trip{"T2", {{.seq_ = 1U, .ev_type_ = event_type::kDep}}}},
+          date::sys_days{2019_y / May / 3} + 7h));
+  EXPECT_EQ(2, on_time.total_entities_success_);
+  ASSERT_EQ(2U, rtt.n_rt_transports());
+  EXPECT_EQ(1U, rtt.n_rt_routes());
+  EXPECT_EQ(rtt.rt_transport_route_[rt_transport_idx_t{0U}],
+            rtt.rt_transport_route_[rt_transport_idx_t{1U}]);
+
+  // T1 is delayed by one hour at B and overtaken by T2: separate RT routes.
+  auto const delayed = rt::gtfsrt_update_msg(
+      tt, rtt, source_idx_t{0}, "tag",
+      test::to_feed_msg(
+          {test::trip{"T1",
+                      {{.seq_ = 2U,
+                        .ev_type_ = event_type::kArr,
+                        .delay_minutes_ = 60}}}},
+          date::sys_days{2019_y / May / 3} + 8h));
+  EXPECT_EQ(1, delayed.total_entities_success_);
+  EXPECT_NE(rtt.rt_transport_route_[rt_transport_idx_t{0U}],
+            rtt.rt_transport_route_[rt_transport_idx_t{1U}]);
+
+  // Boarding T1 at 10:00 would arrive 11:20, T2 arrives at 10:50.
+  auto const results =
+      raptor_search(tt, &rtt, "A", "C", sys_days{May / 3 / 2019} + 8h);
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ(sys_days{May / 3 / 2019} + 8h + 50min,
+            results.begin()->arrival_time());
+}
@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+
+#include "nigiri/routing/search.h"
+
+using namespace nigiri;
+using namespace nigiri::routing;
+
+TEST(routing, search_state_reuses_leg_buffers) {
+  auto const leg = journey::leg{direction::kForward,
+                                location_idx_t{0U},
+                                location_idx_t{1U},
+                                unixtime_t{},
+                                unixtime_t{} + duration_t{5},
+                                footpath{location_idx_t{1U}, duration_t{5}}};
+
+  auto state = search_state{};
+  state.results_.add(journey{.legs_ = {leg, leg},
+                             .dest_time_ = unixtime_t{} + duration_t{10},
+                             .transfers_ = 0U});
+  state.results_.add(journey{.legs_ = {},
+                             .dest_time_ = unixtime_t{} + duration_t{5},
+                             .transfers_ = 1U});
+  ASSERT_EQ(2U, state.results_.size());
+  auto const* buffer = state.results_.els_.front().legs_.data();
+
+  state.clear_results();
+  EXPECT_TRUE(state.results_.empty());
+  ASSERT_EQ(1U, state.leg_buffers_.size());
+
+  auto j = journey{};
+  state.reuse_leg_buffer(j);
+  EXPECT_TRUE(j.legs_.empty());
+  EXPECT_EQ(buffer, j.legs_.data());
+  EXPECT_TRUE(state.leg_buffers_.empty());
+
+  // Journeys that already own a buffer keep it.
+  auto other = journey{.legs_ = {leg}};
+  state.leg_buffers_.emplace_back(std::vector<journey::leg>{leg});
+  state.reuse_leg_buffer(other);
+  EXPECT_EQ(1U, other.legs_.size());
+  EXPECT_EQ(1U, state.leg_buffers_.size());
+}
@@ -226,6 +226,18 @@ pareto_set<routing::journey> search(timetable const& tt,
     pong_results_str = print_results(tt, *pong_results.journeys_);
   }
 
+  auto parallel_pong_results_str = std::string{};
+  {
+    auto parallel_q = q;
+    parallel_q.parallel_lower_bounds_ = true;
+    auto search_state = routing::search_state{};
+    auto raptor_state = routing::raptor_state{};
+    auto const pong_results = routing::pong_search(
+        tt, rtt, search_state, raptor_state, std::move(parallel_q), dir);
+    parallel_pong_results_str = print_results(tt, *pong_results.journeys_);
+  }
+  EXPECT_EQ(pong_results_str, parallel_pong_results_str);
+
   EXPECT_EQ(rraptor_results_str, pong_results_str)
       << "dir=" << to_str(dir)  //
       << ", from=" << loc{tt, q.start_[0].target()}  //
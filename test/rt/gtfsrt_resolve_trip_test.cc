@@ -243,7 +243,7 @@ TEST(rt, gtfs_rt_update) {
   // Create empty RT timetable.
   auto rtt = rt_timetable{};
   rtt.transport_traffic_days_ = tt.transport_traffic_days_;
-  rtt.bitfields_ = tt.bitfields_;
+  rtt.bitfields_ = compress(tt.bitfields_);
   rtt.base_day_ = date::sys_days{2019_y / May / 3};
   rtt.base_day_idx_ = tt.day_idx(rtt.base_day_);
   rtt.location_rt_transports_[location_idx_t{tt.n_locations() - 1U}];
@@ -268,3 +268,29 @@ TEST(rt, json_to_xml) {
   EXPECT_EQ(base_day + 4h + 44min, fr_rt[2].time(event_type::kDep));
   EXPECT_EQ(base_day + 4h + 57min, fr_rt[3].time(event_type::kArr));
 }
+
+TEST(rt, siri_json_native) {
+  auto const base_day = date::sys_days{2025_y / October / 25};
+  auto tt = loader::load({{.tag_ = "test",
+                           .path_ = kGtfsTimetable,
+                           .loader_config_ = {.default_tz_ = "UTC"}}},
+                         {}, {base_day, date::sys_days{2025_y / October / 26}});
+
+  auto rtt = rt::create_rt_timetable(tt, base_day);
+  auto updater = rt::vdv_aus::updater{
+      tt, source_idx_t{0}, rt::vdv_aus::updater::xml_format::kSiriJson};
+  auto const stats = updater.update(rtt, std::string_view{kIn});
+  EXPECT_EQ(1U, stats.total_runs_);
+  EXPECT_EQ(4U, stats.resolved_stops_);
+  EXPECT_EQ(1U, stats.found_runs_);
+
+  auto const fr_rt = resolve(tt, &rtt, "7621", "20251025");
+  ASSERT_EQ(4U, fr_rt.size());
+  EXPECT_TRUE(fr_rt.is_rt());
+  EXPECT_EQ(base_day + 3h + 1min, fr_rt[0].time(event_type::kDep));
+  EXPECT_EQ(base_day + 3h + 39min, fr_rt[1].time(event_type::kArr));
+  EXPECT_EQ(base_day + 3h + 52min, fr_rt[1].time(event_type::kDep));
+  EXPECT_EQ(base_day + 4h + 27min, fr_rt[2].time(event_type::kArr));
+  EXPECT_EQ(base_day + 4h + 44min, fr_rt[2].time(event_type::kDep));
+  EXPECT_EQ(base_day + 4h + 57min, fr_rt[3].time(event_type::kArr));
+}
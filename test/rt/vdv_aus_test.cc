@@ -1,3 +1,5 @@
+#include <filesystem>
+
 #include "gtest/gtest.h"
 
 #include "pugixml.hpp"
@@ -456,6 +458,52 @@ TEST(vdv_aus, delay_propagation) {
   EXPECT_EQ(u.get_cumulative_stats().propagated_delays_, 9);
 }
 
+TEST(vdv_aus, match_snapshot) {
+  timetable tt;
+  register_special_stations(tt);
+  tt.date_range_ = {date::sys_days{2024_y / July / 1},
+                    date::sys_days{2024_y / July / 31}};
+  auto const src_idx = source_idx_t{0};
+  load_timetable({}, src_idx, vdv_test_files(), tt);
+  finalize(tt);
+
+  auto doc = pugi::xml_document{};
+  doc.load_string(vdv_aus_msg0);
+
+  auto const snapshot_path =
+      std::filesystem::temp_directory_path() / "vdv-aus-match-snapshot";
+  {
+    auto rtt = rt::create_rt_timetable(tt, date::sys_days{2024_y / July / 10});
+    auto u = rt::vdv_aus::updater{tt, src_idx};
+    u.update(rtt, doc);
+    ASSERT_EQ(1U, u.get_cumulative_stats().matched_runs_);
+    u.write_matches(snapshot_path);
+  }
+
+  auto other_src = rt::vdv_aus::updater{tt, source_idx_t{1}};
+  EXPECT_EQ(0U, other_src.read_matches(snapshot_path));
+
+  auto rtt = rt::create_rt_timetable(tt, date::sys_days{2024_y / July / 10});
+  auto u = rt::vdv_aus::updater{tt, src_idx};
+  EXPECT_EQ(1U, u.read_matches(snapshot_path));
+  EXPECT_EQ(1U, u.get_cumulative_stats().restored_matches_);
+
+  auto const stats = u.update(rtt, doc);
+  EXPECT_EQ(0U, stats.match_attempts_);
+  EXPECT_EQ(1U, stats.match_cache_hits_);
+  EXPECT_EQ(1U, stats.restored_match_hits_);
+  EXPECT_EQ(1U, stats.found_runs_);
+
+  auto fr = rt::frun(
+      tt, &rtt,
+      {{transport_idx_t{0}, day_idx_t{13}}, {stop_idx_t{0}, stop_idx_t{5}}});
+  EXPECT_EQ(fr[3].time(event_type::kArr),
+            date::sys_days{2024_y / July / 10} + 1_hours + 5_minutes);
+
+  std::filesystem::remove(snapshot_path);
+  EXPECT_EQ(0U, rt::vdv_aus::updater{tt, src_idx}.read_matches(snapshot_path));
+}
+
 TEST(vdv_aus, all_stops_canceled) {
   timetable tt;
   register_special_stations(tt);
@@ -223,4 +223,33 @@ TEST(td_footpath, backward_last) {
   auto const fp = get_td_duration<direction::kBackward>(fps, x);
 
   ASSERT_TRUE(fp.has_value());
-}
\ No newline at end of file
+}
+
+TEST(td_footpath, many_windows) {
+  // Alternating 5min / 10min windows every hour for three targets.
+  auto const start = sys_days{2024_y / June / 15};
+  auto fps = std::vector<td_footpath>{};
+  for (auto target = 0U; target != 3U; ++target) {
+    for (auto h = 0; h != 200; ++h) {
+      fps.push_back({location_idx_t{target}, start + std::chrono::hours{h},
+                     h % 2 == 0 ? 5min : 10min});
+    }
+  }
+
+  auto const t = start + 101h + 30min;
+  EXPECT_EQ(10min, get_td_duration<direction::kForward>(
+                       std::span{fps}.subspan(0U, 200U), t)
+                       ->first);
+  EXPECT_EQ(10min, get_td_duration<direction::kBackward>(
+                       std::span{fps}.subspan(0U, 200U), t)
+                       ->first);
+
+  auto targets = std::vector<location_idx_t>{};
+  for_each_footpath<direction::kForward>(fps, t, [&](footpath const fp) {
+    targets.push_back(fp.target());
+    EXPECT_EQ(10min, fp.duration());
+  });
+  EXPECT_EQ((std::vector<location_idx_t>{location_idx_t{0U}, location_idx_t{1U},
+                                         location_idx_t{2U}}),
+            targets);
+}